@@ -8,6 +8,13 @@ extern "C" {
 #endif
 typedef enum metric {
     METRIC_BLOCK_COMPILATION = 0,
+    METRIC_BLOCK_COMPILATION_NS,
+    METRIC_BLOCK_GUEST_INSTRUCTIONS,
+    METRIC_BLOCK_HOST_BYTES,
+    METRIC_BLOCK_INVALIDATION,
+    METRIC_BLOCK_HOT_RECOMPILATION,
+    METRIC_BLOCK_PAGE_PINNED,
+    METRIC_BLOCK_PINNED_INSTRUCTIONS,
     METRIC_RSP_STEPS,
     METRIC_AUDIOSTREAM_AVAILABLE,
     METRIC_SI_INTERRUPT,
@@ -24,7 +31,7 @@ INLINE void mark_metric(metric_t metric) {
     n64_metric_data[metric]++;
 }
 
-INLINE void mark_metric_multiple(metric_t metric, int times) {
+INLINE void mark_metric_multiple(metric_t metric, uint64_t times) {
     n64_metric_data[metric] += times;
 }
 
@@ -2,6 +2,7 @@
 #define __UTIL_H__
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
 typedef uint8_t u8;
@@ -31,12 +32,15 @@ typedef int64_t s64;
 #ifdef N64_WIN
 #define ASSERTWORD(type) _Static_assert(sizeof(type) == 4, "must be 32 bits")
 #define ASSERTDWORD(type) _Static_assert(sizeof(type) == 8, "must be 64 bits")
+#define ASSERTWITHIN(type, field, bytes) _Static_assert(offsetof(type, field) + sizeof(((type*)0)->field) <= (bytes), "must be in the first " #bytes " bytes")
 #elif defined(__cplusplus)
 #define ASSERTWORD(type) static_assert(sizeof(type) == 4, #type " must be 32 bits")
 #define ASSERTDWORD(type) static_assert(sizeof(type) == 8, #type " must be 64 bits")
+#define ASSERTWITHIN(type, field, bytes) static_assert(offsetof(type, field) + sizeof(((type*)0)->field) <= (bytes), #type "." #field " must be in the first " #bytes " bytes")
 #else
 #define ASSERTWORD(type) _Static_assert(sizeof(type) == 4, #type " must be 32 bits")
 #define ASSERTDWORD(type) _Static_assert(sizeof(type) == 8, #type " must be 64 bits")
+#define ASSERTWITHIN(type, field, bytes) _Static_assert(offsetof(type, field) + sizeof(((type*)0)->field) <= (bytes), #type "." #field " must be in the first " #bytes " bytes")
 #endif
 
 #ifndef N64_WIN
@@ -5,6 +5,17 @@
 #include <system/n64system.h>
 #include <dynasm/dasm_proto.h>
 
+// Upper bound on the number of DynASM global labels (->name:) in asm_emitter.dasc, checked at compile time.
+#define DYNAREC_ARENA_MAX_GLOBALS 8
+
+// Everything compilation needs that's worth keeping between blocks. The DynASM state owns the action buffers,
+// the relocation/section buffers and the dynamic label table, so reusing it means a block compile no longer
+// has to malloc and free all of them every time.
+typedef struct dynarec_arena {
+    dasm_State* d;
+    void* globals[DYNAREC_ARENA_MAX_GLOBALS];
+} dynarec_arena_t;
+
 #define COMPILER(name) void compile_##name(dasm_State** Dst, mips_instruction_t instr, u32 address, int* aregs, int dreg, u32* extra_cycles)
 
 COMPILER(mips_addiu);
@@ -161,7 +172,12 @@ COMPILER(mips_cp_c_lt_s);
 COMPILER(mips_cp_c_le_d);
 COMPILER(mips_cp_c_le_s);
 
-dasm_State* block_header();
+dasm_State** block_header(dynarec_arena_t* arena);
+void block_entry_point(dasm_State** Dst, int entry);
+void block_entry_stub(dasm_State** Dst, int entry, int instructions_skipped);
+int block_entry_stub_offset(dasm_State** Dst, int entry);
+void compile_idiom(dasm_State** Dst, uintptr_t handler, u32 regs, u64 loop_address);
+void compile_hle_call(dasm_State** Dst, uintptr_t handler, u64 function_address, int length);
 void clear_branch_flag(dasm_State** Dst);
 void advance_pc(dasm_State** Dst);
 void advance_rsp_pc(dasm_State** Dst);
@@ -170,6 +186,9 @@ dynarec_ir_t* rsp_instruction_ir(mips_instruction_t instr, u32 address);
 void end_block(dasm_State** Dst, int block_length);
 void end_rsp_block(dasm_State** Dst, int block_length);
 void post_branch_likely(dasm_State** Dst, int block_length);
+void begin_side_exit(dasm_State** Dst, u64 expected_pc);
+void side_exit_taken(dasm_State** Dst);
+void end_side_exit(dasm_State** Dst);
 void check_exception(dasm_State** Dst, u32 block_length);
 void set_prev_branch_flag(dasm_State** Dst, bool value);
 #ifdef N64_DEBUG_MODE
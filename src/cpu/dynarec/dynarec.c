@@ -1,25 +1,110 @@
 #include "dynarec.h"
 
+#include <stdlib.h>
+#include <time.h>
 #include <mem/n64bus.h>
+#include <mem/mem_util.h>
 #include <dynasm/dasm_proto.h>
 #include <metrics.h>
 #include "cpu/dynarec/asm_emitter.h"
 #include "dynarec_memory_management.h"
+#include "dynarec_idioms.h"
+#include "dynarec_warm.h"
+#include "dynarec_corpus.h"
+#include <frontend/libultra_hle.h>
 
 #define IS_PAGE_BOUNDARY(address) ((address & (BLOCKCACHE_PAGE_SIZE - 1)) == 0)
 
-static void* link_and_encode(dasm_State** d) {
-    size_t code_size;
-    dasm_link(d, &code_size);
+static dynarec_arena_t arena;
+
+// Also allocates the block's exit, if it needs one. Both come out of the same allocation so a code cache flush can't
+// happen in between and leave one of them pointing into freed space.
+static void* link_and_encode(dasm_State** d, size_t* code_size, bool needs_exit, dynarec_block_exit_t** exit) {
+    dasm_link(d, code_size);
 #ifdef N64_LOG_COMPILATIONS
-    printf("Generated %ld bytes of code\n", code_size);
+    printf("Generated %ld bytes of code\n", *code_size);
 #endif
-    void* buf = dynarec_bumpalloc(code_size);
+    size_t exit_offset = (*code_size + 7) & ~7;
+    size_t alloc_size = needs_exit ? exit_offset + sizeof(dynarec_block_exit_t) : *code_size;
+    u8* buf = dynarec_bumpalloc(alloc_size);
     dasm_encode(d, buf);
 
+    if (needs_exit) {
+        *exit = (dynarec_block_exit_t*)&buf[exit_offset];
+        memset(*exit, 0, sizeof(dynarec_block_exit_t));
+    } else {
+        *exit = NULL;
+    }
+
     return buf;
 }
 
+INLINE bool block_exit_type(mips_instruction_t instr, dynarec_block_exit_type_t* type) {
+    switch (instr.op) {
+        case OPC_JAL:
+            *type = BLOCK_EXIT_CALL;
+            return true;
+        case OPC_REGIMM:
+            if (instr.i.rt == RT_BLTZAL || instr.i.rt == RT_BGEZAL || instr.i.rt == RT_BGEZALL) {
+                *type = BLOCK_EXIT_CALL;
+                return true;
+            }
+            return false;
+        case OPC_SPCL:
+            if (instr.r.funct == FUNCT_JALR) {
+                *type = BLOCK_EXIT_INDIRECT_CALL;
+                return true;
+            } else if (instr.r.funct == FUNCT_JR) {
+                *type = instr.r.rs == 31 ? BLOCK_EXIT_RETURN : BLOCK_EXIT_INDIRECT;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+INLINE u64 compile_timestamp_ns() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static n64_dynarec_block_stats_t* get_block_stats(u32 physical_address) {
+    u32 outer_index = dynarec_outer_index(physical_address);
+    n64_dynarec_page_stats_t* page_stats = N64DYNAREC->page_stats[outer_index];
+    if (unlikely(page_stats == NULL)) {
+        page_stats = calloc(1, sizeof(n64_dynarec_page_stats_t));
+        N64DYNAREC->page_stats[outer_index] = page_stats;
+    }
+    return &page_stats->blocks[BLOCKCACHE_INNER_INDEX(physical_address)];
+}
+
+INLINE u32 page_invalidations(u32 physical_address) {
+    return N64DYNAREC->page_stats[dynarec_outer_index(physical_address)]->invalidations;
+}
+
+static void record_block_stats(u64 virtual_address, u32 physical_address, u64 compile_time_ns, u32 guest_length, u32 host_size) {
+    n64_dynarec_block_stats_t* stats = get_block_stats(physical_address);
+    u32 current_page_invalidations = page_invalidations(physical_address);
+
+    if (stats->compilations > 0 && stats->page_invalidations_at_compile != current_page_invalidations) {
+        stats->invalidations++;
+    }
+
+    stats->virtual_address = virtual_address;
+    stats->physical_address = physical_address;
+    stats->compile_time_ns = compile_time_ns;
+    stats->guest_length = guest_length;
+    stats->host_size = host_size;
+    stats->compilations++;
+    stats->page_invalidations_at_compile = current_page_invalidations;
+
+    mark_metric_multiple(METRIC_BLOCK_COMPILATION_NS, compile_time_ns);
+    mark_metric_multiple(METRIC_BLOCK_GUEST_INSTRUCTIONS, guest_length);
+    mark_metric_multiple(METRIC_BLOCK_HOST_BYTES, host_size);
+}
+
 static int arg_host_registers[] = {0, 0};
 static int dest_host_register = 0;
 static int valid_host_regs[32];
@@ -28,6 +113,9 @@ static int num_available_host_regs;
 static bool guest_reg_loaded[32];
 static bool host_reg_used[32];
 static int guest_reg_to_host_reg[32];
+// Guest registers whose values are known at compile time, e.g. MMIO bases loaded with lui
+static bool guest_reg_constant[32];
+static u64 guest_reg_constant_value[32];
 
 INLINE bool is_reg_loaded(int guest) {
     return guest_reg_loaded[guest];
@@ -80,6 +168,15 @@ INLINE void flush_all(dasm_State** Dst) {
     }
 }
 
+// Stores every loaded register back, but leaves them loaded. For exits that the rest of the block doesn't go through.
+INLINE void write_back_all(dasm_State** Dst) {
+    for (int r = 0; r < 32; r++) {
+        if (is_reg_loaded(r)) {
+            flush_host_register_to_gpr(Dst, valid_host_regs[guest_reg_to_host_reg[r]], r);
+        }
+    }
+}
+
 INLINE void load_reg_1(dasm_State** Dst, int* dest1, int r1) {
     bool r1_loaded = is_reg_loaded(r1);
 
@@ -122,6 +219,135 @@ INLINE void load_reg_3(dasm_State** Dst, int* dest1, int r1, int* dest2, int r2,
     }
 }
 
+bool dynarec_guest_reg_constant(int guest, u64* value) {
+    if (guest == 0) {
+        *value = 0;
+        return true;
+    }
+    *value = guest_reg_constant_value[guest];
+    return guest_reg_constant[guest];
+}
+
+INLINE void set_guest_reg_constant(int guest, u64 value) {
+    guest_reg_constant[guest] = true;
+    guest_reg_constant_value[guest] = value;
+}
+
+INLINE void clear_guest_reg_constant(int guest) {
+    guest_reg_constant[guest] = false;
+}
+
+// Called after an instruction is compiled to keep track of which guest registers hold values known at compile time.
+// Only the usual ways of building an address (lui, ori, addiu, daddiu) produce constants, every other GPR write clears them.
+static void update_guest_reg_constants(mips_instruction_t instr) {
+    u64 rs_value;
+    bool rs_constant = dynarec_guest_reg_constant(instr.i.rs, &rs_value);
+    s16 imm = instr.i.immediate;
+
+    switch (instr.op) {
+        case OPC_LUI:
+            set_guest_reg_constant(instr.i.rt, se_32_64((u32)instr.i.immediate << 16));
+            break;
+        case OPC_ORI:
+            if (rs_constant) {
+                set_guest_reg_constant(instr.i.rt, rs_value | instr.i.immediate);
+            } else {
+                clear_guest_reg_constant(instr.i.rt);
+            }
+            break;
+        case OPC_ADDIU:
+            if (rs_constant) {
+                set_guest_reg_constant(instr.i.rt, se_32_64((u32)rs_value + (s32)imm));
+            } else {
+                clear_guest_reg_constant(instr.i.rt);
+            }
+            break;
+        case OPC_DADDIU:
+            if (rs_constant) {
+                set_guest_reg_constant(instr.i.rt, rs_value + (s64)imm);
+            } else {
+                clear_guest_reg_constant(instr.i.rt);
+            }
+            break;
+
+        // Everything else that writes rt
+        case OPC_ADDI:
+        case OPC_DADDI:
+        case OPC_ANDI:
+        case OPC_XORI:
+        case OPC_SLTI:
+        case OPC_SLTIU:
+        case OPC_LB:
+        case OPC_LBU:
+        case OPC_LH:
+        case OPC_LHU:
+        case OPC_LW:
+        case OPC_LWU:
+        case OPC_LWL:
+        case OPC_LWR:
+        case OPC_LD:
+        case OPC_LDL:
+        case OPC_LDR:
+        case OPC_LL:
+        case OPC_LLD:
+        case OPC_SC:
+        case OPC_SCD:
+            clear_guest_reg_constant(instr.i.rt);
+            break;
+
+        // No GPR writes
+        case OPC_SB:
+        case OPC_SH:
+        case OPC_SW:
+        case OPC_SD:
+        case OPC_SWL:
+        case OPC_SWR:
+        case OPC_SDL:
+        case OPC_SDR:
+        case OPC_LWC1:
+        case OPC_LDC1:
+        case OPC_SWC1:
+        case OPC_SDC1:
+        case OPC_CACHE:
+        case OPC_BEQ:
+        case OPC_BEQL:
+        case OPC_BNE:
+        case OPC_BNEL:
+        case OPC_BLEZ:
+        case OPC_BLEZL:
+        case OPC_BGTZ:
+        case OPC_BGTZL:
+        case OPC_J:
+            break;
+
+        case OPC_JAL:
+            clear_guest_reg_constant(31);
+            break;
+
+        case OPC_REGIMM:
+            if (instr.i.rt == RT_BLTZAL || instr.i.rt == RT_BGEZAL || instr.i.rt == RT_BGEZALL) {
+                clear_guest_reg_constant(31);
+            }
+            break;
+
+        case OPC_SPCL:
+            // Instructions that don't write rd (mult, jr, etc) encode it as 0, so this is always safe
+            clear_guest_reg_constant(instr.r.rd);
+            break;
+
+        case OPC_CP0:
+        case OPC_CP1:
+            if (instr.r.rs == COP_MF || instr.r.rs == COP_DMF || instr.r.rs == COP_CF) {
+                clear_guest_reg_constant(instr.r.rt);
+            }
+            break;
+
+        default:
+            memset(guest_reg_constant, 0, sizeof(guest_reg_constant));
+            break;
+    }
+}
+
 bool branch_is_loop(mips_instruction_t instr, u32 block_length) {
     switch (instr.op) {
         case OPC_REGIMM: // REGIMM opcodes are only branches
@@ -145,17 +371,145 @@ bool branch_is_loop(mips_instruction_t instr, u32 block_length) {
     }
 }
 
-void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_address, u32 physical_address) {
+/*
+ * Forward conditional branches are guessed not taken, so the block carries on past the delay slot and gets a side exit
+ * for when the branch is taken. Backward branches are usually loops and are guessed taken, so they still end the block.
+ * Branches that link are calls, and are left alone so the return address stack still sees them.
+ */
+bool branch_predicted_not_taken(mips_instruction_t instr) {
+    s16 offset = instr.i.immediate;
+    switch (instr.op) {
+        case OPC_BEQ:
+            // beq with the same register twice is an unconditional branch
+            return offset > 0 && instr.i.rs != instr.i.rt;
+        case OPC_BNE:
+        case OPC_BLEZ:
+        case OPC_BGTZ:
+            return offset > 0;
+        case OPC_REGIMM:
+            return offset > 0 && (instr.i.rt == RT_BLTZ || instr.i.rt == RT_BGEZ);
+        case OPC_CP1:
+            return offset > 0 && instr.r.rs == COP_BC;
+        default:
+            return false;
+    }
+}
+
+static int missing_block_handler();
+
+INLINE bool static_branch_target(mips_instruction_t instr, u64 address, u64* target) {
+    switch (instr.op) {
+        case OPC_J:
+        case OPC_JAL:
+            *target = ((address + 4) & ~0x0FFFFFFFULL) | (instr.j.target << 2);
+            return true;
+        case OPC_REGIMM: // Also the trap immediates, a few extra entry points don't hurt
+        case OPC_BEQ:
+        case OPC_BEQL:
+        case OPC_BGTZ:
+        case OPC_BGTZL:
+        case OPC_BLEZ:
+        case OPC_BLEZL:
+        case OPC_BNE:
+        case OPC_BNEL:
+            *target = address + 4 + ((s64)(s16)instr.i.immediate << 2);
+            return true;
+        case OPC_CP1:
+            if (instr.r.rs == COP_BC) {
+                *target = address + 4 + ((s64)(s16)instr.i.immediate << 2);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Instructions in the page being compiled that a branch or jump somewhere in the same page goes to
+static bool page_branch_targets[BLOCKCACHE_INNER_SIZE];
+
+// Host memory backing a whole page, or NULL for pages that aren't plain RDRAM or cart ROM.
+static u8* page_host_memory(u32 page_physical) {
+    if (page_physical + BLOCKCACHE_PAGE_SIZE <= N64_RDRAM_SIZE) {
+        return n64sys.mem.rdram + page_physical;
+    }
+    if (page_physical >= SREGION_CART_1_2 && page_physical - SREGION_CART_1_2 + BLOCKCACHE_PAGE_SIZE <= n64sys.mem.rom.size) {
+        return n64sys.mem.rom.rom + (page_physical - SREGION_CART_1_2);
+    }
+    return NULL;
+}
+
+static void find_page_branch_targets(u64 virtual_address, u32 physical_address) {
+    u64 page_virtual = virtual_address & ~(u64)(BLOCKCACHE_PAGE_SIZE - 1);
+    u32 page_physical = physical_address & ~(BLOCKCACHE_PAGE_SIZE - 1);
+    memset(page_branch_targets, 0, sizeof(page_branch_targets));
+
+    // Reading the page through the bus would hit the PIF, SP memory and registers, with their side effects, and
+    // reserved space past the end of them. Code running from there just doesn't get extra entry points.
+    u8* page = page_host_memory(page_physical);
+    if (page == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < BLOCKCACHE_INNER_SIZE; i++) {
+        mips_instruction_t instr;
+        instr.raw = word_from_byte_array(page, i * 4);
+        u64 target;
+        if (static_branch_target(instr, page_virtual + i * 4, &target) && (target & ~(u64)(BLOCKCACHE_PAGE_SIZE - 1)) == page_virtual) {
+            page_branch_targets[BLOCKCACHE_INNER_INDEX(target)] = true;
+        }
+    }
+}
+
+typedef struct block_entry {
+    n64_dynarec_block_t* block;
+    int instructions_skipped;
+} block_entry_t;
+
+// Emits a stub for each entry point, links the code, and points the block and its entry points at it.
+static void install_block(dasm_State** Dst, n64_dynarec_block_t* block, block_entry_t* entries, int num_entries,
+                          bool has_exit, dynarec_block_exit_type_t exit_type, u64 return_address,
+                          u64 virtual_address, u32 physical_address, u64 compile_start, int guest_length) {
+    for (int i = 0; i < num_entries; i++) {
+        block_entry_stub(Dst, i, entries[i].instructions_skipped);
+    }
+    size_t code_size;
+    dynarec_block_exit_t* exit;
+    void* compiled = link_and_encode(Dst, &code_size, has_exit, &exit);
+    if (has_exit) {
+        exit->type = exit_type;
+        exit->return_address = return_address;
+    }
+
+    block->run = compiled;
+    block->exit = exit;
+    for (int i = 0; i < num_entries; i++) {
+        entries[i].block->run = (void*)((u8*)compiled + block_entry_stub_offset(Dst, i));
+        entries[i].block->exit = exit;
+    }
+
+    record_block_stats(virtual_address, physical_address, compile_timestamp_ns() - compile_start, guest_length, code_size);
+}
+
+void compile_new_block(n64_dynarec_block_t* block_list, bool* code_mask, u64 virtual_address, u32 physical_address) {
     mark_metric(METRIC_BLOCK_COMPILATION);
-    static dasm_State* d;
-    d = block_header();
-    dasm_State** Dst = &d;
+    n64_dynarec_block_t* block = &block_list[BLOCKCACHE_INNER_INDEX(physical_address)];
+    u64 compile_start = compile_timestamp_ns();
+    u64 block_virtual_address = virtual_address;
+    u32 block_physical_address = physical_address;
+    dasm_State** Dst = block_header(&arena);
 
     memset(guest_reg_loaded, 0, sizeof(guest_reg_loaded));
     memset(host_reg_used, 0, sizeof(host_reg_used));
+    memset(guest_reg_constant, 0, sizeof(guest_reg_constant));
 
     num_available_host_regs = num_valid_host_regs;
 
+    dynarec_idiom_t idiom;
+    if (detect_loop_idiom(physical_address, &idiom)) {
+        compile_idiom(Dst, (uintptr_t)idiom.handler, idiom.regs, virtual_address);
+    }
+
     bool should_continue_block = true;
     int block_length = 0;
     int block_extra_cycles = 0;
@@ -170,10 +524,34 @@ void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_
     bool block_is_stable = true;
     bool block_is_loop = false;
 
+    bool block_has_exit = false;
+    dynarec_block_exit_type_t block_exit = BLOCK_EXIT_CALL;
+    u64 block_return_address = 0;
+
+    int side_exits = 0;
+    bool continue_after_delay_slot = false;
+
+    // Branch targets inside the block that don't have a block of their own yet get an entry point here instead
+    block_entry_t entries[DYNAREC_MAX_BLOCK_ENTRIES];
+    int num_entries = 0;
+    find_page_branch_targets(virtual_address, physical_address);
+
     do {
         mips_instruction_t instr;
         instr.raw = n64_read_physical_word(physical_address);
 
+        n64_dynarec_block_t* entry_block = &block_list[BLOCKCACHE_INNER_INDEX(physical_address)];
+        if (block_length > 0 && !is_branch(prev_instr_category) && num_entries < DYNAREC_MAX_BLOCK_ENTRIES
+                && page_branch_targets[BLOCKCACHE_INNER_INDEX(physical_address)] && entry_block->run == missing_block_handler) {
+            // Nothing can be assumed about the registers when coming in from the entry point
+            flush_all(Dst);
+            memset(guest_reg_constant, 0, sizeof(guest_reg_constant));
+            block_entry_point(Dst, num_entries);
+            entries[num_entries].block = entry_block;
+            entries[num_entries].instructions_skipped = block_length + block_extra_cycles;
+            num_entries++;
+        }
+
         code_mask[BLOCKCACHE_INNER_INDEX(physical_address)] = true;
 
         block_is_stable &= instruction_stable(instr);
@@ -224,6 +602,7 @@ void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_
             set_prev_branch_flag(Dst, prev_instr_category == BRANCH || prev_instr_category == BRANCH_LIKELY);
         }
         ir->compiler(Dst, instr, physical_address, arg_host_registers, dest_host_register, &extra_cycles);
+        update_guest_reg_constants(instr);
         block_length++;
         block_extra_cycles += extra_cycles;
         if (ir->exception_possible) {
@@ -262,6 +641,9 @@ void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_
                 instructions_left_in_block = 1; // emit delay slot
 
                 block_is_loop = branch_is_loop(instr, block_length);
+                block_has_exit = block_exit_type(instr, &block_exit);
+                block_return_address = virtual_address + 8;
+                continue_after_delay_slot = side_exits < DYNAREC_SUPERBLOCK_MAX_SIDE_EXITS && branch_predicted_not_taken(instr);
                 break;
 
             case BRANCH_LIKELY:
@@ -305,6 +687,24 @@ void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_
         // !!!!!!!!!!!!!!! WARNING !!!!!!!!!!!!!!!
         if (instructions_left_in_block == 1) { page_boundary_ends_block = false; } // FIXME, TODO, BAD, EVIL, etc
 
+        bool delay_slot_done = prev_instr_category == BRANCH && ir->category == NORMAL && instructions_left_in_block == 0;
+        if (delay_slot_done && continue_after_delay_slot && !page_boundary_ends_block) {
+            // The branch has already set the PC, so if it went anywhere but the next instruction, leave the block here.
+            begin_side_exit(Dst, next_virtual_address);
+            side_exit_taken(Dst);
+            write_back_all(Dst);
+            end_block(Dst, block_length + block_extra_cycles);
+            end_side_exit(Dst);
+
+            side_exits++;
+            instr_ends_block = false;
+            instructions_left_in_block = -1;
+            branch_in_block = false;
+            block_is_loop = false;
+            block_has_exit = false;
+        }
+        continue_after_delay_slot &= !delay_slot_done;
+
         if (instr_ends_block || page_boundary_ends_block) {
 #ifdef N64_LOG_COMPILATIONS
             printf("Ending block. instr: %d pb: %d (0x%08X)\n", instr_ends_block, page_boundary_ends_block, next_physical_address);
@@ -325,12 +725,93 @@ void compile_new_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_
     }
     flush_all(Dst);
     end_block(Dst, block_length + block_extra_cycles);
-    void* compiled = link_and_encode(&d);
-    dasm_free(&d);
+    install_block(Dst, block, entries, num_entries, block_has_exit, block_exit, block_return_address,
+                  block_virtual_address, block_physical_address, compile_start, block_length);
+    dynarec_corpus_record(block_virtual_address, block_physical_address, block_length);
+}
 
-    block->run = compiled;
+// Compiles the block as a call to a native replacement, if it's the start of a function in the libultra HLE catalogue.
+static bool compile_hle_block(n64_dynarec_block_t* block, bool* code_mask, u64 virtual_address, u32 physical_address) {
+    // Cache ops in user mode would raise an exception, leave that to the real code.
+    if (!libultra_hle_enabled() || !N64CP0.kernel_mode) {
+        return false;
+    }
+
+    u64 compile_start = compile_timestamp_ns();
+    int length;
+    const libultra_hle_entry_t* hle = libultra_hle_match(physical_address, &length);
+    if (hle == NULL) {
+        return false;
+    }
+
+    mark_metric(METRIC_BLOCK_COMPILATION);
+    for (int i = 0; i < length; i++) {
+        code_mask[BLOCKCACHE_INNER_INDEX(physical_address + i * 4)] = true;
+    }
+
+    dasm_State** Dst = block_header(&arena);
+    compile_hle_call(Dst, (uintptr_t)hle->handler, virtual_address, length);
+    install_block(Dst, block, NULL, 0, true, BLOCK_EXIT_RETURN, 0, virtual_address, physical_address, compile_start, length);
+    return true;
+}
+
+static void compile_block(n64_dynarec_block_t* block_list, bool* code_mask, u64 virtual_address, u32 physical_address) {
+    n64_dynarec_block_t* block = &block_list[BLOCKCACHE_INNER_INDEX(physical_address)];
+    if (!compile_hle_block(block, code_mask, virtual_address, physical_address)) {
+        compile_new_block(block_list, code_mask, virtual_address, physical_address);
+    }
+}
+
+static bool compiling_hot_block = false;
+
+bool dynarec_compiling_hot_block() {
+    return compiling_hot_block;
+}
+
+static void recompile_hot_block() {
+    u32 physical;
+    if (!resolve_virtual_address(N64CPU.pc, BUS_LOAD, &physical)) {
+        return;
+    }
+    u32 outer_index = dynarec_outer_index(physical);
+    n64_dynarec_block_t* block_list = N64DYNAREC->blockcache[outer_index];
+    bool* code_mask = N64DYNAREC->code_mask[outer_index];
+
+    mark_metric(METRIC_BLOCK_HOT_RECOMPILATION);
+    compiling_hot_block = true;
+    compile_block(block_list, code_mask, N64CPU.pc, physical);
+    compiling_hot_block = false;
 }
 
+// Compiles the blocks the warm block list has for this page, as long as their code hasn't changed since the list was built.
+static void compile_warm_blocks(u32 outer_index, n64_dynarec_block_t* block_list, bool* code_mask) {
+    int count;
+    const dynarec_warm_block_t* warm_blocks = dynarec_warm_page_blocks(outer_index, &count);
+    for (int i = 0; i < count; i++) {
+        if (N64DYNAREC->codecache_size - N64DYNAREC->codecache_used < DYNAREC_WARM_CODECACHE_MARGIN) {
+            break;
+        }
+
+        const dynarec_warm_block_t* warm = &warm_blocks[i];
+        n64_dynarec_block_t* block = &block_list[BLOCKCACHE_INNER_INDEX(warm->physical_address)];
+        if (block->run == missing_block_handler && dynarec_warm_guest_hash(warm->physical_address, warm->guest_length) == warm->guest_hash) {
+            compile_block(block_list, code_mask, warm->virtual_address, warm->physical_address);
+        }
+    }
+}
+
+u32 n64_dynarec_compile_block(u64 virtual_address, u32 physical_address) {
+    static n64_dynarec_block_t block_list[BLOCKCACHE_INNER_SIZE];
+    static bool code_mask[BLOCKCACHE_INNER_SIZE];
+    // Start from a fresh page every time, the same as n64_dynarec_step() would give the block
+    memset(block_list, 0, sizeof(block_list));
+    for (int i = 0; i < BLOCKCACHE_INNER_SIZE; i++) {
+        block_list[i].run = missing_block_handler;
+    }
+    memset(code_mask, 0, sizeof(code_mask));
+    compile_new_block(block_list, code_mask, virtual_address, physical_address);
+    return get_block_stats(physical_address)->guest_length;
+}
 
 static int missing_block_handler() {
     u32 physical = resolve_virtual_address_or_die(N64CPU.pc, BUS_LOAD);
@@ -345,44 +826,169 @@ static int missing_block_handler() {
     printf("Compilin' new block at 0x%08X / 0x%08X\n", N64CPU.pc, physical);
 #endif
 
-    compile_new_block(block, code_mask, N64CPU.pc, physical);
+    compile_warm_blocks(outer_index, block_list, code_mask);
+    if (block->run == missing_block_handler) {
+        compile_block(block_list, code_mask, N64CPU.pc, physical);
+    }
 
+    N64DYNAREC->run_exit = block->exit;
     return block->run(&N64CPU);
 }
 
-int n64_dynarec_step() {
-    u32 physical;
-    if (!resolve_virtual_address(N64CPU.pc, BUS_LOAD, &physical)) {
-        on_tlb_exception(N64CPU.pc);
-        r4300i_handle_exception(N64CPU.pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
-        printf("TLB miss PC, now at %016lX\n", N64CPU.pc);
-        return 1; // TODO does exception handling have a cost by itself? does it matter?
+void dynarec_reset_block_links(n64_dynarec_t* dynarec) {
+    memset(dynarec->return_address_stack, 0, sizeof(dynarec->return_address_stack));
+    dynarec->return_address_stack_top = 0;
+    dynarec->last_exit = NULL;
+}
+
+INLINE void push_return_address(dynarec_block_exit_t* exit) {
+    N64DYNAREC->return_address_stack_top = (N64DYNAREC->return_address_stack_top + 1) % DYNAREC_RAS_SIZE;
+    N64DYNAREC->return_address_stack[N64DYNAREC->return_address_stack_top] = exit;
+}
+
+INLINE dynarec_block_exit_t* pop_return_address() {
+    dynarec_block_exit_t* exit = N64DYNAREC->return_address_stack[N64DYNAREC->return_address_stack_top];
+    N64DYNAREC->return_address_stack[N64DYNAREC->return_address_stack_top] = NULL;
+    N64DYNAREC->return_address_stack_top = (N64DYNAREC->return_address_stack_top + DYNAREC_RAS_SIZE - 1) % DYNAREC_RAS_SIZE;
+    return exit;
+}
+
+// Picks the link to check based on how the last block exited. NULL if there's nothing to predict with.
+INLINE dynarec_block_link_t* predicted_block_link() {
+    dynarec_block_exit_t* exit = N64DYNAREC->last_exit;
+    if (exit == NULL) {
+        return NULL;
     }
 
-    u32 outer_index = physical >> BLOCKCACHE_OUTER_SHIFT;
-    n64_dynarec_block_t* block_list = N64DYNAREC->blockcache[outer_index];
-    u32 inner_index = BLOCKCACHE_INNER_INDEX(physical);
+    switch (exit->type) {
+        case BLOCK_EXIT_RETURN: {
+            dynarec_block_exit_t* call = pop_return_address();
+            if (call != NULL && call->return_address == N64CPU.pc) {
+                return &call->return_link;
+            }
+            return NULL;
+        }
+        case BLOCK_EXIT_INDIRECT:
+        case BLOCK_EXIT_INDIRECT_CALL:
+            return &exit->inline_cache;
+        default:
+            return NULL;
+    }
+}
 
-    if (unlikely(block_list == NULL)) {
+INLINE n64_dynarec_block_t* follow_block_link(dynarec_block_link_t* link) {
+    if (link->block != NULL && link->virtual_address == N64CPU.pc && N64DYNAREC->blockcache[link->outer_index] == link->block_list) {
+        return link->block;
+    }
+    return NULL;
+}
+
+INLINE void update_block_link(dynarec_block_link_t* link, u32 outer_index, n64_dynarec_block_t* block_list, n64_dynarec_block_t* block) {
+    // Only link to KSEG0 and KSEG1, their translation can never change. TLB mapped targets always take the slow path.
+    u64 pc = N64CPU.pc;
+    if (se_32_64(pc) == pc && ((u32)pc >> 30) == 0b10) {
+        link->virtual_address = pc;
+        link->outer_index = outer_index;
+        link->block_list = block_list;
+        link->block = block;
+    }
+}
+
+// Once a pinned page's cool-down is over it gets compiled again, and has to thrash all over again to be re-pinned.
+INLINE bool page_pinned_to_interpreter(u32 outer_index) {
+    n64_dynarec_page_stats_t* page_stats = N64DYNAREC->page_stats[outer_index];
+    if (likely(page_stats == NULL || page_stats->pinned_until == 0)) {
+        return false;
+    }
+    if (scheduler_ticks < page_stats->pinned_until) {
+        return true;
+    }
+    page_stats->pinned_until = 0;
+    page_stats->window_start = scheduler_ticks;
+    page_stats->window_invalidations = 0;
+    return false;
+}
+
+// Interprets until the code leaves the page, or for about as long as a block would run. Never stops in a delay slot.
+static int interpret_pinned_page(u32 outer_index) {
+    N64DYNAREC->last_exit = NULL;
+    int steps = 0;
+    u32 physical;
+    do {
+        r4300i_step();
+        steps++;
+    } while (N64CPU.branch || (steps < DYNAREC_PINNED_PAGE_MAX_STEPS
+                               && resolve_virtual_address(N64CPU.pc, BUS_LOAD, &physical)
+                               && dynarec_outer_index(physical) == outer_index));
+
+    mark_metric_multiple(METRIC_BLOCK_PINNED_INSTRUCTIONS, steps);
+    return steps * CYCLES_PER_INSTR;
+}
+
+int n64_dynarec_step() {
+    dynarec_block_link_t* link = predicted_block_link();
+    n64_dynarec_block_t* block = link != NULL ? follow_block_link(link) : NULL;
+
+    if (block == NULL) {
+        u32 physical;
+        if (!resolve_virtual_address(N64CPU.pc, BUS_LOAD, &physical)) {
+            N64DYNAREC->last_exit = NULL;
+            on_tlb_exception(N64CPU.pc);
+            r4300i_handle_exception(N64CPU.pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
+            printf("TLB miss PC, now at %016lX\n", N64CPU.pc);
+            return 1; // TODO does exception handling have a cost by itself? does it matter?
+        }
+
+        u32 outer_index = physical >> BLOCKCACHE_OUTER_SHIFT;
+        n64_dynarec_block_t* block_list = N64DYNAREC->blockcache[outer_index];
+        u32 inner_index = BLOCKCACHE_INNER_INDEX(physical);
+
+        if (unlikely(block_list == NULL)) {
+            if (unlikely(page_pinned_to_interpreter(outer_index))) {
+                return interpret_pinned_page(outer_index);
+            }
 #ifdef N64_LOG_COMPILATIONS
-        printf("Need a new block list for page 0x%05X (address 0x%08X virtual 0x%08X)\n", outer_index, physical, N64CPU.pc);
+            printf("Need a new block list for page 0x%05X (address 0x%08X virtual 0x%08X)\n", outer_index, physical, N64CPU.pc);
 #endif
-        block_list = dynarec_bumpalloc_zero(BLOCKCACHE_INNER_SIZE * sizeof(n64_dynarec_block_t));
-        for (int i = 0; i < BLOCKCACHE_INNER_SIZE; i++) {
-            block_list[i].run = missing_block_handler;
+            block_list = dynarec_bumpalloc_zero(BLOCKCACHE_INNER_SIZE * sizeof(n64_dynarec_block_t));
+            for (int i = 0; i < BLOCKCACHE_INNER_SIZE; i++) {
+                block_list[i].run = missing_block_handler;
+            }
+            N64DYNAREC->blockcache[outer_index] = block_list;
+            N64DYNAREC->code_mask[outer_index] = dynarec_bumpalloc_zero(BLOCKCACHE_INNER_SIZE * sizeof(bool));
+            if (N64DYNAREC->protect_rdram) {
+                dynarec_protect_rdram_page(outer_index);
+            }
+            // Allocating the lists can flush the code cache, which takes the link with it
+            link = NULL;
+        }
+
+        block = &block_list[inner_index];
+        if (link != NULL) {
+            update_block_link(link, outer_index, block_list, block);
         }
-        N64DYNAREC->blockcache[outer_index] = block_list;
-        N64DYNAREC->code_mask[outer_index] = dynarec_bumpalloc_zero(BLOCKCACHE_INNER_SIZE * sizeof(bool));
     }
 
-    n64_dynarec_block_t* block = &block_list[inner_index];
+    // Stops counting once the block is hot, so it can't wrap around and be recompiled again
+    if (block->executions < DYNAREC_HOT_BLOCK_THRESHOLD
+            && unlikely(++block->executions == DYNAREC_HOT_BLOCK_THRESHOLD) && block->run != missing_block_handler) {
+        recompile_hot_block();
+    }
 
 #ifdef LOG_ENABLED
     static long total_blocks_run;
     logdebug("Running block at 0x%016lX - block run #%ld - block FP: 0x%016lX", N64CPU.pc, ++total_blocks_run, (uintptr_t)block->run);
 #endif
     N64CPU.exception = false;
+    N64DYNAREC->run_exit = block->exit;
     int taken = block->run(&N64CPU);
+
+    // Read after running, the block may have just been compiled, or left through a side exit.
+    dynarec_block_exit_t* exit = N64DYNAREC->run_exit;
+    if (exit != NULL && (exit->type == BLOCK_EXIT_CALL || exit->type == BLOCK_EXIT_INDIRECT_CALL)) {
+        push_return_address(exit);
+    }
+    N64DYNAREC->last_exit = exit;
 #ifdef N64_LOG_JIT_SYNC_POINTS
     printf("JITSYNC %d %08X ", taken, N64CPU.pc);
     for (int i = 0; i < 32; i++) {
@@ -423,4 +1029,62 @@ void invalidate_dynarec_all_pages(n64_dynarec_t* dynarec) {
     for (int i = 0; i < BLOCKCACHE_OUTER_SIZE; i++) {
         dynarec->blockcache[i] = NULL;
     }
-}
\ No newline at end of file
+    dynarec_reset_block_links(dynarec);
+    dynarec_warm_reset_pages();
+}
+
+static int compare_block_stats_by_compile_time(const void* a, const void* b) {
+    const n64_dynarec_block_stats_t* block_a = *(const n64_dynarec_block_stats_t**)a;
+    const n64_dynarec_block_stats_t* block_b = *(const n64_dynarec_block_stats_t**)b;
+    if (block_a->compile_time_ns < block_b->compile_time_ns) {
+        return 1;
+    } else if (block_a->compile_time_ns > block_b->compile_time_ns) {
+        return -1;
+    }
+    return 0;
+}
+
+// Prints every block compiled so far, slowest to compile first. max_rows <= 0 prints all of them.
+void n64_dynarec_dump_block_stats(FILE* fp, int max_rows) {
+    int num_blocks = 0;
+    for (int outer = 0; outer < BLOCKCACHE_OUTER_SIZE; outer++) {
+        n64_dynarec_page_stats_t* page_stats = N64DYNAREC->page_stats[outer];
+        if (page_stats != NULL) {
+            for (int inner = 0; inner < BLOCKCACHE_INNER_SIZE; inner++) {
+                num_blocks += page_stats->blocks[inner].compilations > 0;
+            }
+        }
+    }
+
+    n64_dynarec_block_stats_t** blocks = malloc(num_blocks * sizeof(n64_dynarec_block_stats_t*));
+    int index = 0;
+    for (int outer = 0; outer < BLOCKCACHE_OUTER_SIZE; outer++) {
+        n64_dynarec_page_stats_t* page_stats = N64DYNAREC->page_stats[outer];
+        if (page_stats != NULL) {
+            for (int inner = 0; inner < BLOCKCACHE_INNER_SIZE; inner++) {
+                n64_dynarec_block_stats_t* stats = &page_stats->blocks[inner];
+                if (stats->compilations > 0) {
+                    blocks[index++] = stats;
+                }
+            }
+        }
+    }
+
+    qsort(blocks, num_blocks, sizeof(n64_dynarec_block_stats_t*), compare_block_stats_by_compile_time);
+
+    fprintf(fp, "%-10s %-18s %8s %10s %10s %12s %8s %8s\n", "physical", "virtual", "guest", "host", "host/guest", "compile (us)", "compiles", "invals");
+    for (int i = 0; i < num_blocks && (max_rows <= 0 || i < max_rows); i++) {
+        n64_dynarec_block_stats_t* stats = blocks[i];
+        u32 invalidations = stats->invalidations;
+        if (stats->page_invalidations_at_compile != page_invalidations(stats->physical_address)) {
+            // Thrown away and not yet recompiled
+            invalidations++;
+        }
+        fprintf(fp, "0x%08X 0x%016lX %8u %10u %10.2f %12.2f %8u %8u\n",
+                stats->physical_address, stats->virtual_address, stats->guest_length, stats->host_size,
+                (double)stats->host_size / stats->guest_length, stats->compile_time_ns / 1000.0,
+                stats->compilations, invalidations);
+    }
+
+    free(blocks);
+}
@@ -4,6 +4,7 @@
 #include <system/n64system.h>
 #include <dynasm/dasm_proto.h>
 #include <common/util.h>
+#include <metrics.h>
 
 // 4KiB aligned pages
 #define BLOCKCACHE_OUTER_SHIFT 12
@@ -46,10 +47,78 @@ typedef struct dynarec_ir {
     mipsinstr_compiler_t compiler;
 } dynarec_ir_t;
 
+typedef enum dynarec_block_exit_type {
+    BLOCK_EXIT_CALL,          // jal, bltzal, etc
+    BLOCK_EXIT_INDIRECT_CALL, // jalr
+    BLOCK_EXIT_RETURN,        // jr $ra
+    BLOCK_EXIT_INDIRECT       // jr to anything else
+} dynarec_block_exit_type_t;
+
+typedef struct n64_dynarec_block n64_dynarec_block_t;
+
+// Remembers which block a jump went to last time, so the address translation and block cache lookup
+// can be skipped when it goes there again. Only valid as long as the page's block list is still the current one.
+typedef struct dynarec_block_link {
+    u64 virtual_address;
+    u32 outer_index;
+    n64_dynarec_block_t* block_list;
+    n64_dynarec_block_t* block;
+} dynarec_block_link_t;
+
+typedef struct dynarec_block_exit {
+    dynarec_block_exit_type_t type;
+    u64 return_address;
+    dynarec_block_link_t return_link; // Where returning from this call went last time
+    dynarec_block_link_t inline_cache; // Where this indirect jump went last time
+} dynarec_block_exit_t;
+
 typedef struct n64_dynarec_block {
     int (*run)(r4300i_t* cpu);
+    dynarec_block_exit_t* exit; // NULL unless the block ends in a call or an indirect jump
+    u32 executions; // Stops counting at DYNAREC_HOT_BLOCK_THRESHOLD
 } n64_dynarec_block_t;
 
+// Blocks that run this many times get compiled again with the more expensive optimizations
+#define DYNAREC_HOT_BLOCK_THRESHOLD 10000
+
+// Most conditional branches a block will compile through before ending, each one gets a side exit
+#define DYNAREC_SUPERBLOCK_MAX_SIDE_EXITS 8
+
+// Most places a block can be entered other than its start. Branch targets in the middle of a block get one of these,
+// instead of a second copy of the code from there on.
+#define DYNAREC_MAX_BLOCK_ENTRIES 16
+
+#define DYNAREC_RAS_SIZE 32
+
+typedef struct n64_dynarec_block_stats {
+    u64 virtual_address;
+    u32 physical_address;
+    u64 compile_time_ns; // Most recent compilation only
+    u32 guest_length; // In instructions
+    u32 host_size; // In bytes
+    u32 compilations;
+    u32 invalidations;
+    // Value of the page's invalidation counter when this block was last compiled.
+    // If the page's counter has moved on since, this block was thrown away.
+    u32 page_invalidations_at_compile;
+} n64_dynarec_block_stats_t;
+
+// Pages that get invalidated more than DYNAREC_THRASH_INVALIDATIONS times within DYNAREC_THRASH_WINDOW_CYCLES are
+// run in the interpreter for DYNAREC_THRASH_COOLDOWN_CYCLES instead of being compiled again and again.
+#define DYNAREC_THRASH_INVALIDATIONS 8
+#define DYNAREC_THRASH_WINDOW_CYCLES (CPU_HERTZ / 10)
+#define DYNAREC_THRASH_COOLDOWN_CYCLES CPU_HERTZ
+// Longest run of instructions interpreted in one go on a pinned page
+#define DYNAREC_PINNED_PAGE_MAX_STEPS 64
+
+typedef struct n64_dynarec_page_stats {
+    u32 invalidations;
+    u32 window_invalidations; // Since window_start
+    u64 window_start;
+    u64 pinned_until; // The page runs in the interpreter until the scheduler gets here
+    n64_dynarec_block_stats_t blocks[BLOCKCACHE_INNER_SIZE];
+} n64_dynarec_page_stats_t;
+
 typedef struct n64_dynarec {
     u8* codecache;
     u64 codecache_size;
@@ -57,6 +126,21 @@ typedef struct n64_dynarec {
 
     n64_dynarec_block_t* blockcache[BLOCKCACHE_OUTER_SIZE];
     bool* code_mask[BLOCKCACHE_OUTER_SIZE];
+    // Allocated the first time a block in the page is compiled, lives as long as the dynarec.
+    n64_dynarec_page_stats_t* page_stats[BLOCKCACHE_OUTER_SIZE];
+
+    // Shadow return address stack. Pushed by blocks ending in a call, popped by blocks ending in jr $ra.
+    // Wraps around when full, a mispredicted return just falls back to the normal lookup.
+    dynarec_block_exit_t* return_address_stack[DYNAREC_RAS_SIZE];
+    int return_address_stack_top;
+    dynarec_block_exit_t* last_exit; // Exit of the block that ran last
+    // Exit the running block left by. Set to the block's final exit before it runs, side exits clear it since they
+    // leave through a plain branch instead.
+    dynarec_block_exit_t* run_exit;
+
+    // RDRAM pages with compiled code are write protected, and writes to them are caught by a fault handler instead
+    // of checking every store against the code mask.
+    bool protect_rdram;
 } n64_dynarec_t;
 
 INLINE u32 dynarec_outer_index(u32 physical_address) {
@@ -64,6 +148,22 @@ INLINE u32 dynarec_outer_index(u32 physical_address) {
 }
 
 INLINE void invalidate_dynarec_page_by_index(u32 outer_index) {
+    if (N64DYNAREC->blockcache[outer_index] != NULL) {
+        mark_metric(METRIC_BLOCK_INVALIDATION);
+        n64_dynarec_page_stats_t* page_stats = N64DYNAREC->page_stats[outer_index];
+        if (page_stats != NULL) {
+            page_stats->invalidations++;
+
+            if (scheduler_ticks - page_stats->window_start > DYNAREC_THRASH_WINDOW_CYCLES) {
+                page_stats->window_start = scheduler_ticks;
+                page_stats->window_invalidations = 0;
+            }
+            if (++page_stats->window_invalidations > DYNAREC_THRASH_INVALIDATIONS) {
+                mark_metric(METRIC_BLOCK_PAGE_PINNED);
+                page_stats->pinned_until = scheduler_ticks + DYNAREC_THRASH_COOLDOWN_CYCLES;
+            }
+        }
+    }
     N64DYNAREC->blockcache[outer_index] = NULL;
 }
 
@@ -73,14 +173,23 @@ INLINE bool is_code(u32 physical_address) {
 }
 
 INLINE void invalidate_dynarec_page(u32 physical_address) {
+    if (N64DYNAREC->protect_rdram && physical_address < N64_RDRAM_SIZE) {
+        return;
+    }
     if (unlikely(is_code(physical_address))) {
         invalidate_dynarec_page_by_index(dynarec_outer_index(physical_address));
     }
 }
 
+bool dynarec_guest_reg_constant(int guest, u64* value);
+bool dynarec_compiling_hot_block();
+void dynarec_reset_block_links(n64_dynarec_t* dynarec);
 int n64_dynarec_step();
+// Compiles the block without running it or adding it to the block cache. Returns its length in guest instructions.
+u32 n64_dynarec_compile_block(u64 virtual_address, u32 physical_address);
 n64_dynarec_t* n64_dynarec_init(u8* codecache, size_t codecache_size);
 void invalidate_dynarec_page(u32 physical_address);
 void invalidate_dynarec_all_pages();
+void n64_dynarec_dump_block_stats(FILE* fp, int max_rows);
 
 #endif //N64_DYNAREC_H
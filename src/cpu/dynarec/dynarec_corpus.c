@@ -0,0 +1,107 @@
+#include "dynarec_corpus.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <log.h>
+#include <mem/n64bus.h>
+
+// Longest a block can be: the rest of the page, plus a delay slot in the next one
+#define CORPUS_MAX_BLOCK_LENGTH (BLOCKCACHE_INNER_SIZE + 1)
+
+static FILE* recording = NULL;
+
+bool dynarec_corpus_start_recording(const char* path) {
+    dynarec_corpus_stop_recording();
+    recording = fopen(path, "wb");
+    if (recording == NULL) {
+        logwarn("Unable to open %s for writing", path);
+        return false;
+    }
+    if (fwrite(DYNAREC_CORPUS_MAGIC, 8, 1, recording) != 1) {
+        logwarn("Unable to write to %s", path);
+        fclose(recording);
+        recording = NULL;
+        return false;
+    }
+    logalways("Recording compiled blocks to %s", path);
+    return true;
+}
+
+void dynarec_corpus_stop_recording() {
+    if (recording != NULL) {
+        fclose(recording);
+        recording = NULL;
+    }
+}
+
+void dynarec_corpus_record(u64 virtual_address, u32 physical_address, u32 guest_length) {
+    if (likely(recording == NULL)) {
+        return;
+    }
+
+    dynarec_corpus_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.virtual_address = virtual_address;
+    entry.physical_address = physical_address;
+    entry.cp0_status = N64CP0.status.raw;
+    entry.guest_length = guest_length;
+
+    u32 code[CORPUS_MAX_BLOCK_LENGTH];
+    for (u32 i = 0; i < guest_length; i++) {
+        code[i] = n64_read_physical_word(physical_address + i * 4);
+    }
+
+    if (fwrite(&entry, sizeof(entry), 1, recording) != 1 || fwrite(code, sizeof(u32), guest_length, recording) != guest_length) {
+        logwarn("Failed to record a block, stopping recording");
+        dynarec_corpus_stop_recording();
+    }
+}
+
+dynarec_corpus_block_t* dynarec_corpus_load(const char* path, u32* num_blocks) {
+    *num_blocks = 0;
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        logwarn("Unable to open block corpus %s", path);
+        return NULL;
+    }
+
+    char magic[8];
+    if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, DYNAREC_CORPUS_MAGIC, sizeof(magic)) != 0) {
+        logwarn("%s is not a block corpus", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    u32 capacity = 1024;
+    dynarec_corpus_block_t* blocks = malloc(capacity * sizeof(dynarec_corpus_block_t));
+    dynarec_corpus_entry_t entry;
+    while (fread(&entry, sizeof(entry), 1, fp) == 1) {
+        if (entry.guest_length == 0 || entry.guest_length > CORPUS_MAX_BLOCK_LENGTH) {
+            logwarn("Block corpus %s is corrupt, stopping after %u blocks", path, *num_blocks);
+            break;
+        }
+        u32* code = malloc(entry.guest_length * sizeof(u32));
+        if (fread(code, sizeof(u32), entry.guest_length, fp) != entry.guest_length) {
+            logwarn("Block corpus %s is truncated, stopping after %u blocks", path, *num_blocks);
+            free(code);
+            break;
+        }
+
+        if (*num_blocks == capacity) {
+            capacity *= 2;
+            blocks = realloc(blocks, capacity * sizeof(dynarec_corpus_block_t));
+        }
+        blocks[*num_blocks].entry = entry;
+        blocks[*num_blocks].code = code;
+        (*num_blocks)++;
+    }
+    fclose(fp);
+    return blocks;
+}
+
+void dynarec_corpus_free(dynarec_corpus_block_t* blocks, u32 num_blocks) {
+    for (u32 i = 0; i < num_blocks; i++) {
+        free(blocks[i].code);
+    }
+    free(blocks);
+}
@@ -0,0 +1,29 @@
+#ifndef N64_DYNAREC_CORPUS_H
+#define N64_DYNAREC_CORPUS_H
+
+#include "dynarec.h"
+
+#define DYNAREC_CORPUS_MAGIC "N64BLK01"
+
+// A recorded corpus is the magic, then one of these per compiled block, each followed by the block's instruction words.
+typedef struct dynarec_corpus_entry {
+    u64 virtual_address;
+    u32 physical_address;
+    u32 cp0_status; // Blocks can compile differently depending on the mode, so they're replayed in the same one
+    u32 guest_length; // In instructions
+    u32 reserved;
+} dynarec_corpus_entry_t;
+
+typedef struct dynarec_corpus_block {
+    dynarec_corpus_entry_t entry;
+    u32* code;
+} dynarec_corpus_block_t;
+
+bool dynarec_corpus_start_recording(const char* path);
+void dynarec_corpus_stop_recording();
+void dynarec_corpus_record(u64 virtual_address, u32 physical_address, u32 guest_length);
+
+dynarec_corpus_block_t* dynarec_corpus_load(const char* path, u32* num_blocks);
+void dynarec_corpus_free(dynarec_corpus_block_t* blocks, u32 num_blocks);
+
+#endif //N64_DYNAREC_CORPUS_H
@@ -0,0 +1,233 @@
+#include "dynarec_idioms.h"
+
+#include <mem/n64bus.h>
+#include <mem/mem_util.h>
+
+#define PACK_REGS(r0, r1, r2, r3, r4) ((r0) | ((r1) << 5) | ((r2) << 10) | ((r3) << 15) | ((r4) << 20))
+#define UNPACK_REG(regs, n) (((regs) >> ((n) * 5)) & 0x1F)
+
+#define WORD_FILL_LENGTH 3
+#define WORD_COPY_LENGTH 5
+
+// Translates a KSEG0/KSEG1 range to RDRAM. Anything else (TLB mapped, MMIO, out of bounds) is left to the real loop.
+INLINE bool idiom_rdram_range(u64 address, u32 length, u32* physical) {
+    if (!N64CP0.kernel_mode || se_32_64(address) != address || ((u32)address >> 30) != 0b10) {
+        return false;
+    }
+    *physical = (u32)address & 0x1FFFFFFF;
+    return *physical + length <= N64_RDRAM_SIZE;
+}
+
+// The loops count a pointer up by 4 until it equals an end register. Only handle the cases where that actually happens.
+INLINE bool idiom_iterations(u64 pointer, u64 end, u32* iterations, bool* done) {
+    if (se_32_64(pointer) != pointer || se_32_64(end) != end) {
+        return false;
+    }
+
+    u32 start = pointer;
+    u32 stop = end;
+    if (stop <= start || ((stop - start) & 3) != 0) {
+        return false;
+    }
+
+    u32 remaining = (stop - start) >> 2;
+    *iterations = remaining < IDIOM_MAX_ITERATIONS ? remaining : IDIOM_MAX_ITERATIONS;
+    *done = *iterations == remaining;
+    return true;
+}
+
+// Leave the CPU in the same state the compiled loop would be in after its last iteration:
+// the delay slot was the last instruction run, and the branch was taken unless the loop is done.
+INLINE void idiom_exit(u64 loop_address, int loop_length, bool done) {
+    u64 delay_slot = loop_address + (loop_length - 1) * 4;
+    N64CPU.prev_pc = delay_slot;
+    N64CPU.pc = done ? delay_slot + 4 : loop_address;
+    N64CPU.next_pc = N64CPU.pc + 4;
+    N64CPU.branch = false;
+    N64CPU.prev_branch = true;
+}
+
+INLINE void idiom_write_word(u32 physical, u32 value) {
+    // Same as the RDRAM case of n64_write_physical_word
+    word_to_byte_array((u8*) &n64sys.mem.rdram, WORD_ADDRESS(physical) - SREGION_RDRAM, value);
+    invalidate_dynarec_page(WORD_ADDRESS(physical));
+}
+
+/*
+ * loop:
+ *   addiu ptr, ptr, 4
+ *   bne   ptr, end, loop
+ *   sw    value, -4(ptr)
+ */
+static int idiom_word_fill(u32 regs, u64 loop_address) {
+    int pointer_reg = UNPACK_REG(regs, 0);
+    int end_reg     = UNPACK_REG(regs, 1);
+    int value_reg   = UNPACK_REG(regs, 2);
+
+    u64 pointer = N64CPU.gpr[pointer_reg];
+    u32 iterations;
+    bool done;
+    u32 physical;
+    // A misaligned pointer makes the real loop's store raise an address error
+    if ((pointer & 3) != 0
+        || !idiom_iterations(pointer, N64CPU.gpr[end_reg], &iterations, &done)
+        || !idiom_rdram_range(pointer, iterations * 4, &physical)) {
+        return 0;
+    }
+
+    u32 value = N64CPU.gpr[value_reg];
+    for (u32 i = 0; i < iterations; i++) {
+        idiom_write_word(physical + i * 4, value);
+    }
+
+    N64CPU.gpr[pointer_reg] = se_32_64((u32)pointer + iterations * 4);
+    idiom_exit(loop_address, WORD_FILL_LENGTH, done);
+    return iterations * WORD_FILL_LENGTH;
+}
+
+/*
+ * loop:
+ *   lw    tmp, 0(src)
+ *   addiu src, src, 4   (these two in either order)
+ *   addiu dst, dst, 4
+ *   bne   src or dst, end, loop
+ *   sw    tmp, -4(dst)
+ */
+static int idiom_word_copy(u32 regs, u64 loop_address) {
+    int src_reg     = UNPACK_REG(regs, 0);
+    int dst_reg     = UNPACK_REG(regs, 1);
+    int tmp_reg     = UNPACK_REG(regs, 2);
+    int end_reg     = UNPACK_REG(regs, 3);
+    int counter_reg = UNPACK_REG(regs, 4);
+
+    u64 src = N64CPU.gpr[src_reg];
+    u64 dst = N64CPU.gpr[dst_reg];
+    u32 iterations;
+    bool done;
+    u32 src_physical;
+    u32 dst_physical;
+    // A misaligned pointer makes the real loop's load or store raise an address error
+    if (((src | dst) & 3) != 0
+        || !idiom_iterations(N64CPU.gpr[counter_reg], N64CPU.gpr[end_reg], &iterations, &done)
+        || !idiom_rdram_range(src, iterations * 4, &src_physical)
+        || !idiom_rdram_range(dst, iterations * 4, &dst_physical)) {
+        return 0;
+    }
+
+    // Copy forwards one word at a time, overlapping ranges need to give the same result as the real loop.
+    u32 value = 0;
+    for (u32 i = 0; i < iterations; i++) {
+        value = word_from_byte_array((u8*) &n64sys.mem.rdram, WORD_ADDRESS(src_physical + i * 4) - SREGION_RDRAM);
+        idiom_write_word(dst_physical + i * 4, value);
+    }
+
+    N64CPU.gpr[tmp_reg] = se_32_64(value);
+    N64CPU.gpr[src_reg] = se_32_64((u32)src + iterations * 4);
+    N64CPU.gpr[dst_reg] = se_32_64((u32)dst + iterations * 4);
+    idiom_exit(loop_address, WORD_COPY_LENGTH, done);
+    return iterations * WORD_COPY_LENGTH;
+}
+
+INLINE bool is_addiu_4(mips_instruction_t instr, int reg) {
+    return instr.op == OPC_ADDIU && instr.i.rs == reg && instr.i.rt == reg && instr.i.immediate == 4;
+}
+
+// bne with a branch target of the start of the loop, comparing counter against some other register
+INLINE bool is_loop_bne(mips_instruction_t instr, int loop_length, int* counter, int* end) {
+    s16 offset = instr.i.immediate;
+    if (instr.op != OPC_BNE || offset != -(loop_length - 1)) {
+        return false;
+    }
+    *counter = instr.i.rs;
+    *end = instr.i.rt;
+    return true;
+}
+
+static bool detect_word_fill(mips_instruction_t* instrs, dynarec_idiom_t* idiom) {
+    int pointer = instrs[0].i.rt;
+    int counter, end;
+    if (pointer == 0 || !is_addiu_4(instrs[0], pointer) || !is_loop_bne(instrs[1], WORD_FILL_LENGTH, &counter, &end)) {
+        return false;
+    }
+    if (counter != pointer) {
+        // bne is symmetrical
+        int temp = counter;
+        counter = end;
+        end = temp;
+    }
+
+    int value = instrs[2].i.rt;
+    s16 store_offset = instrs[2].i.immediate;
+    if (counter != pointer || end == pointer || instrs[2].op != OPC_SW || instrs[2].i.rs != pointer
+        || store_offset != -4 || value == pointer) {
+        return false;
+    }
+
+    idiom->handler = idiom_word_fill;
+    idiom->regs = PACK_REGS(pointer, end, value, 0, 0);
+    return true;
+}
+
+static bool detect_word_copy(mips_instruction_t* instrs, dynarec_idiom_t* idiom) {
+    if (instrs[0].op != OPC_LW || instrs[0].i.immediate != 0) {
+        return false;
+    }
+    int src = instrs[0].i.rs;
+    int tmp = instrs[0].i.rt;
+    int dst;
+
+    if (is_addiu_4(instrs[1], src)) {
+        dst = instrs[2].i.rt;
+        if (!is_addiu_4(instrs[2], dst)) {
+            return false;
+        }
+    } else {
+        dst = instrs[1].i.rt;
+        if (!is_addiu_4(instrs[1], dst) || !is_addiu_4(instrs[2], src)) {
+            return false;
+        }
+    }
+
+    int counter, end;
+    if (!is_loop_bne(instrs[3], WORD_COPY_LENGTH, &counter, &end)) {
+        return false;
+    }
+    if (counter != src && counter != dst) {
+        int temp = counter;
+        counter = end;
+        end = temp;
+    }
+
+    s16 store_offset = instrs[4].i.immediate;
+    if (instrs[4].op != OPC_SW || instrs[4].i.rs != dst || instrs[4].i.rt != tmp || store_offset != -4) {
+        return false;
+    }
+
+    // All registers need to be distinct for the loop to mean what we think it means
+    if (src == 0 || dst == 0 || tmp == 0 || src == dst || tmp == src || tmp == dst
+        || (counter != src && counter != dst) || end == src || end == dst || end == tmp) {
+        return false;
+    }
+
+    idiom->handler = idiom_word_copy;
+    idiom->regs = PACK_REGS(src, dst, tmp, end, counter);
+    return true;
+}
+
+// Checks whether the block starting at physical_address is one of the known memset/bzero/memcpy loop shapes.
+bool detect_loop_idiom(u32 physical_address, dynarec_idiom_t* idiom) {
+    mips_instruction_t instrs[WORD_COPY_LENGTH];
+
+    // The whole loop has to be in the page, or it wouldn't be compiled as a single block.
+    int length = 0;
+    for (; length < WORD_COPY_LENGTH; length++) {
+        u32 address = physical_address + length * 4;
+        if (length > 0 && (address & (BLOCKCACHE_PAGE_SIZE - 1)) == 0) {
+            break;
+        }
+        instrs[length].raw = n64_read_physical_word(address);
+    }
+
+    return (length >= WORD_FILL_LENGTH && detect_word_fill(instrs, idiom))
+        || (length >= WORD_COPY_LENGTH && detect_word_copy(instrs, idiom));
+}
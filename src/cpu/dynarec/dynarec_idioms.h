@@ -0,0 +1,20 @@
+#ifndef N64_DYNAREC_IDIOMS_H
+#define N64_DYNAREC_IDIOMS_H
+
+#include "dynarec.h"
+
+// Upper bound on loop iterations done by a single run of an idiom. Keeps the time between
+// interrupt checks close to what running the loop block by block would give.
+#define IDIOM_MAX_ITERATIONS 256
+
+// Returns the number of guest instructions executed, or 0 if the loop has to run normally this time.
+typedef int (*dynarec_idiom_handler_t)(u32 regs, u64 loop_address);
+
+typedef struct dynarec_idiom {
+    dynarec_idiom_handler_t handler;
+    u32 regs; // Guest registers used by the loop, packed 5 bits each
+} dynarec_idiom_t;
+
+bool detect_loop_idiom(u32 physical_address, dynarec_idiom_t* idiom);
+
+#endif //N64_DYNAREC_IDIOMS_H
@@ -1,6 +1,15 @@
 #include <rsp.h>
+#include <log.h>
 #include "dynarec_memory_management.h"
 #include "dynarec.h"
+#include <system/rsp_thread.h>
+#ifndef N64_WIN
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 void flush_code_cache() {
     // Just set the pointer back to the beginning, no need to clear the actual data.
@@ -10,16 +19,17 @@ void flush_code_cache() {
     for (int i = 0; i < BLOCKCACHE_OUTER_SIZE; i++) {
         N64DYNAREC->blockcache[i] = NULL;
     }
+
+    // The block exits the links point to lived in the code cache too.
+    dynarec_reset_block_links(N64DYNAREC);
 }
 
 void flush_rsp_code_cache() {
     // Just set the pointer back to the beginning, no need to clear the actual data.
     N64RSPDYNAREC->codecache_used = 0;
 
-    // However, the block cache needs to be fully invalidated.
-    for (int i = 0; i < RSP_BLOCKCACHE_SIZE; i++) {
-        N64RSPDYNAREC->blockcache[i].run = rsp_missing_block_handler;
-    }
+    // However, every microcode image's block cache needs to be fully invalidated.
+    rsp_dynarec_reset_images();
 }
 
 void* dynarec_bumpalloc(size_t size) {
@@ -63,3 +73,67 @@ void* rsp_dynarec_bumpalloc(size_t size) {
 
     return ptr;
 }
+
+#ifndef N64_WIN
+static struct sigaction previous_segv_action;
+
+INLINE void set_rdram_page_protection(u32 outer_index, int protection) {
+    u8* page = &n64sys.mem.rdram[outer_index << BLOCKCACHE_OUTER_SHIFT];
+    if (mprotect(page, BLOCKCACHE_PAGE_SIZE, protection) != 0) {
+        logfatal("mprotect of RDRAM page 0x%05X failed! %s", outer_index, strerror(errno));
+    }
+}
+
+// First write to a protected page: throw away its compiled code and let the write go through.
+static void rdram_write_fault_handler(int signal, siginfo_t* info, void* context) {
+    uintptr_t address = (uintptr_t)info->si_addr;
+    uintptr_t rdram = (uintptr_t)n64sys.mem.rdram;
+    if (address >= rdram && address < rdram + N64_RDRAM_SIZE) {
+        u32 outer_index = (address - rdram) >> BLOCKCACHE_OUTER_SHIFT;
+        if (on_rsp_thread) {
+            // An RSP DMA. The block cache belongs to the CPU thread, which throws the code away when it next syncs.
+            rsp_thread_defer_invalidation(outer_index << BLOCKCACHE_OUTER_SHIFT);
+        } else {
+            invalidate_dynarec_page_by_index(outer_index);
+        }
+        set_rdram_page_protection(outer_index, PROT_READ | PROT_WRITE);
+        return;
+    }
+
+    // Not ours. Put the old handler back, the faulting instruction runs again and faults into it.
+    sigaction(SIGSEGV, &previous_segv_action, NULL);
+}
+#endif
+
+bool dynarec_enable_rdram_write_protection() {
+#ifdef N64_WIN
+    logwarn("Write protecting compiled code is not supported on Windows");
+    return false;
+#else
+    if (sysconf(_SC_PAGESIZE) != BLOCKCACHE_PAGE_SIZE) {
+        logwarn("Host page size is not %d bytes, can't write protect compiled code", BLOCKCACHE_PAGE_SIZE);
+        return false;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = rdram_write_fault_handler;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGSEGV, &action, &previous_segv_action) != 0) {
+        logwarn("Unable to install the SIGSEGV handler, can't write protect compiled code");
+        return false;
+    }
+
+    N64DYNAREC->protect_rdram = true;
+    return true;
+#endif
+}
+
+void dynarec_protect_rdram_page(u32 outer_index) {
+#ifndef N64_WIN
+    if (outer_index < (N64_RDRAM_SIZE >> BLOCKCACHE_OUTER_SHIFT)) {
+        set_rdram_page_protection(outer_index, PROT_READ);
+    }
+#endif
+}
@@ -6,4 +6,6 @@
 void* dynarec_bumpalloc(size_t size);
 void* dynarec_bumpalloc_zero(size_t size);
 void* rsp_dynarec_bumpalloc(size_t size);
+bool dynarec_enable_rdram_write_protection();
+void dynarec_protect_rdram_page(u32 outer_index);
 #endif //N64_DYNAREC_MEMORY_MANAGEMENT_H
@@ -0,0 +1,155 @@
+#include "dynarec_warm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <log.h>
+#include <mem/n64bus.h>
+
+#define WARM_NUM_PAGES (N64_RDRAM_SIZE >> BLOCKCACHE_OUTER_SHIFT)
+
+static dynarec_warm_block_t* warm_blocks = NULL;
+static u32 num_warm_blocks = 0;
+// Each page only gets its listed blocks compiled the first time it's needed. After the page is invalidated the code
+// has likely changed, so it goes back to compiling lazily.
+static bool warm_page_done[WARM_NUM_PAGES];
+
+u32 dynarec_warm_guest_hash(u32 physical_address, u32 guest_length) {
+    // FNV-1a over the instruction words
+    u32 hash = 0x811C9DC5;
+    for (u32 i = 0; i < guest_length; i++) {
+        u32 word = n64_read_physical_word(physical_address + i * 4);
+        for (int b = 0; b < 4; b++) {
+            hash ^= (word >> (b * 8)) & 0xFF;
+            hash *= 0x01000193;
+        }
+    }
+    return hash;
+}
+
+static int compare_warm_blocks(const void* a, const void* b) {
+    const dynarec_warm_block_t* block_a = a;
+    const dynarec_warm_block_t* block_b = b;
+    if (block_a->physical_address < block_b->physical_address) {
+        return -1;
+    } else if (block_a->physical_address > block_b->physical_address) {
+        return 1;
+    }
+    return 0;
+}
+
+bool dynarec_warm_write(const char* path, const n64_rom_t* rom, dynarec_warm_block_t* blocks, u32 num_blocks) {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        logwarn("Unable to open %s for writing", path);
+        return false;
+    }
+
+    qsort(blocks, num_blocks, sizeof(dynarec_warm_block_t), compare_warm_blocks);
+
+    dynarec_warm_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DYNAREC_WARM_MAGIC, sizeof(header.magic));
+    header.rom_crc1 = rom->header.crc1;
+    header.rom_crc2 = rom->header.crc2;
+    header.num_blocks = num_blocks;
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(blocks, sizeof(dynarec_warm_block_t), num_blocks, fp) == num_blocks;
+    fclose(fp);
+    return ok;
+}
+
+INLINE bool warm_block_valid(const dynarec_warm_block_t* block) {
+    // Only unmapped addresses, their translation can't change between runs
+    u64 virtual_address = block->virtual_address;
+    return se_32_64(virtual_address) == virtual_address
+        && ((u32)virtual_address >> 30) == 0b10
+        && ((u32)virtual_address & 0x1FFFFFFF) == block->physical_address
+        && block->physical_address < N64_RDRAM_SIZE
+        && block->guest_length > 0 && block->guest_length <= BLOCKCACHE_INNER_SIZE;
+}
+
+bool dynarec_warm_load(const char* path, const n64_rom_t* rom) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        logwarn("Unable to open warm block list %s", path);
+        return false;
+    }
+
+    dynarec_warm_header_t header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, DYNAREC_WARM_MAGIC, sizeof(header.magic)) != 0) {
+        logwarn("%s is not a warm block list", path);
+        fclose(fp);
+        return false;
+    }
+
+    if (header.rom_crc1 != rom->header.crc1 || header.rom_crc2 != rom->header.crc2) {
+        logwarn("Warm block list %s was built for a different ROM, ignoring it", path);
+        fclose(fp);
+        return false;
+    }
+
+    if (header.num_blocks > N64_RDRAM_SIZE / 4) {
+        logwarn("Warm block list %s lists more blocks than there are instructions in RDRAM, ignoring it", path);
+        fclose(fp);
+        return false;
+    }
+
+    dynarec_warm_block_t* blocks = malloc(header.num_blocks * sizeof(dynarec_warm_block_t));
+    if (fread(blocks, sizeof(dynarec_warm_block_t), header.num_blocks, fp) != header.num_blocks) {
+        logwarn("Warm block list %s is truncated, ignoring it", path);
+        free(blocks);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    u32 num_valid = 0;
+    for (u32 i = 0; i < header.num_blocks; i++) {
+        if (warm_block_valid(&blocks[i])) {
+            blocks[num_valid++] = blocks[i];
+        }
+    }
+    qsort(blocks, num_valid, sizeof(dynarec_warm_block_t), compare_warm_blocks);
+
+    free(warm_blocks);
+    warm_blocks = blocks;
+    num_warm_blocks = num_valid;
+    dynarec_warm_reset_pages();
+
+    logalways("Loaded %u blocks from warm block list %s", num_valid, path);
+    return true;
+}
+
+const dynarec_warm_block_t* dynarec_warm_page_blocks(u32 outer_index, int* count) {
+    *count = 0;
+    if (num_warm_blocks == 0 || outer_index >= WARM_NUM_PAGES || warm_page_done[outer_index]) {
+        return NULL;
+    }
+    warm_page_done[outer_index] = true;
+
+    // Find the first block in the page
+    u32 page_start = outer_index << BLOCKCACHE_OUTER_SHIFT;
+    u32 low = 0;
+    u32 high = num_warm_blocks;
+    while (low < high) {
+        u32 mid = low + (high - low) / 2;
+        if (warm_blocks[mid].physical_address < page_start) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    u32 end = low;
+    while (end < num_warm_blocks && dynarec_outer_index(warm_blocks[end].physical_address) == outer_index) {
+        end++;
+    }
+
+    *count = end - low;
+    return &warm_blocks[low];
+}
+
+void dynarec_warm_reset_pages() {
+    memset(warm_page_done, 0, sizeof(warm_page_done));
+}
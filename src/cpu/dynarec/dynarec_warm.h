@@ -0,0 +1,37 @@
+#ifndef N64_DYNAREC_WARM_H
+#define N64_DYNAREC_WARM_H
+
+#include "dynarec.h"
+
+// A warm block list is the guest addresses of blocks reachable from a ROM's entry point, found offline by the
+// warm_block_list tool. No host code is precompiled or saved: the first time a listed page runs, all of its listed
+// blocks are JIT compiled in one go instead of one at a time as execution reaches them.
+
+#define DYNAREC_WARM_MAGIC "N64WARM1"
+// Stop compiling a page's listed blocks when the code cache gets this close to full. A flush in the middle of the
+// batch would take the page's block list with it.
+#define DYNAREC_WARM_CODECACHE_MARGIN (1 << 20)
+
+typedef struct dynarec_warm_header {
+    char magic[8];
+    u32 rom_crc1;
+    u32 rom_crc2;
+    u32 num_blocks;
+    u32 reserved;
+} dynarec_warm_header_t;
+
+typedef struct dynarec_warm_block {
+    u64 virtual_address;
+    u32 physical_address;
+    u32 guest_length;
+    u32 guest_hash; // Of the block's code when the list was built. If it doesn't match, the block is left to the JIT.
+    u32 reserved;
+} dynarec_warm_block_t;
+
+u32 dynarec_warm_guest_hash(u32 physical_address, u32 guest_length);
+bool dynarec_warm_write(const char* path, const n64_rom_t* rom, dynarec_warm_block_t* blocks, u32 num_blocks);
+bool dynarec_warm_load(const char* path, const n64_rom_t* rom);
+const dynarec_warm_block_t* dynarec_warm_page_blocks(u32 outer_index, int* count);
+void dynarec_warm_reset_pages();
+
+#endif //N64_DYNAREC_WARM_H
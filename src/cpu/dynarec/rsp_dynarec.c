@@ -18,12 +18,10 @@ void* rsp_link_and_encode(dasm_State** d) {
 
 #define NEXT(address) ((address + 4) & 0xFFF)
 
-void compile_new_rsp_block(rsp_dynarec_block_t* block, u16 address) {
-    static dasm_State* d;
-    static dasm_State** Dst;
+static dynarec_arena_t rsp_arena;
 
-    d = block_header();
-    Dst = &d;
+void compile_new_rsp_block(rsp_dynarec_block_t* block, u16 address) {
+    dasm_State** Dst = block_header(&rsp_arena);
 
     int block_length = 0;
     int block_extra_cycles = 0;
@@ -100,7 +98,6 @@ void compile_new_rsp_block(rsp_dynarec_block_t* block, u16 address) {
 
     end_rsp_block(Dst, block_length + block_extra_cycles);
     void* compiled = rsp_link_and_encode(Dst);
-    dasm_free(Dst);
 
     block->run = compiled;
 }
@@ -112,15 +109,68 @@ int rsp_missing_block_handler() {
     return block->run(&N64RSP);
 }
 
+INLINE void reset_image(rsp_ucode_image_t* image) {
+    image->valid = false;
+    for (int i = 0; i < RSP_BLOCKCACHE_SIZE; i++) {
+        image->blockcache[i].run = rsp_missing_block_handler;
+    }
+}
+
+void rsp_dynarec_select_image() {
+    rsp_dynarec_t* dynarec = N64RSPDYNAREC;
+    dynarec->imem_dirty = false;
+    u64 hash = rsp_imem_hash();
+
+    rsp_ucode_image_t* least_recently_used = &dynarec->images[0];
+    for (int i = 0; i < RSP_NUM_UCODE_IMAGES; i++) {
+        rsp_ucode_image_t* image = &dynarec->images[i];
+        if (image->valid && image->hash == hash) {
+            bool same = true;
+            for (int j = 0; j < RSP_BLOCKCACHE_SIZE && same; j++) {
+                same = image->imem[j] == word_from_byte_array(N64RSP.sp_imem, j * 4);
+            }
+            if (same) {
+                image->last_used = ++dynarec->image_clock;
+                dynarec->blockcache = image->blockcache;
+                return;
+            }
+        }
+        if (!image->valid || (least_recently_used->valid && image->last_used < least_recently_used->last_used)) {
+            least_recently_used = image;
+        }
+    }
+
+    // Not seen this microcode recently, start compiling it from scratch in place of the one that's gone unused longest
+    rsp_ucode_image_t* image = least_recently_used;
+    reset_image(image);
+    image->valid = true;
+    image->hash = hash;
+    image->last_used = ++dynarec->image_clock;
+    for (int i = 0; i < RSP_BLOCKCACHE_SIZE; i++) {
+        image->imem[i] = word_from_byte_array(N64RSP.sp_imem, i * 4);
+    }
+    dynarec->blockcache = image->blockcache;
+    logdebug("New RSP microcode image with hash %016lX", hash);
+}
+
+void rsp_dynarec_reset_images() {
+    for (int i = 0; i < RSP_NUM_UCODE_IMAGES; i++) {
+        reset_image(&N64RSPDYNAREC->images[i]);
+    }
+    N64RSPDYNAREC->imem_dirty = true;
+}
+
 rsp_dynarec_t* rsp_dynarec_init(u8* codecache, size_t codecache_size) {
     rsp_dynarec_t* dynarec = calloc(1, sizeof(rsp_dynarec_t));
 
     dynarec->codecache_size = codecache_size;
     dynarec->codecache_used = 0;
 
-    for (int i = 0; i < RSP_BLOCKCACHE_SIZE; i++) {
-        dynarec->blockcache[i].run = rsp_missing_block_handler;
+    for (int i = 0; i < RSP_NUM_UCODE_IMAGES; i++) {
+        reset_image(&dynarec->images[i]);
     }
+    dynarec->blockcache = dynarec->images[0].blockcache;
+    dynarec->imem_dirty = true;
 
     dynarec->codecache = codecache;
 
@@ -128,5 +178,8 @@ rsp_dynarec_t* rsp_dynarec_init(u8* codecache, size_t codecache_size) {
 }
 
 int rsp_dynarec_step() {
+    if (unlikely(N64RSPDYNAREC->imem_dirty)) {
+        rsp_dynarec_select_image();
+    }
     return N64RSPDYNAREC->blockcache[N64RSP.pc & 0x3FF].run(&N64RSP);
 }
@@ -14,16 +14,34 @@ typedef struct rsp_dynarec_block {
     int (*run)(rsp_t* cpu);
 } rsp_dynarec_block_t;
 
+// How many different microcodes to keep compiled code for. Games switch between audio and graphics ucodes (and their
+// overlays) several times a frame, so IMEM gets rewritten constantly, but with only a handful of distinct images.
+#define RSP_NUM_UCODE_IMAGES 8
+
+typedef struct rsp_ucode_image {
+    bool valid;
+    u64 hash;
+    u64 last_used;
+    u32 imem[RSP_BLOCKCACHE_SIZE]; // To tell apart images whose hashes collide
+    rsp_dynarec_block_t blockcache[RSP_BLOCKCACHE_SIZE];
+} rsp_ucode_image_t;
+
 typedef struct rsp_dynarec {
     u8* codecache;
     u64 codecache_size;
     u64 codecache_used;
 
-    rsp_dynarec_block_t blockcache[RSP_BLOCKCACHE_SIZE];
+    // Set on any write to IMEM. The image to run from gets looked up again before the next block.
+    bool imem_dirty;
+    u64 image_clock;
+    rsp_dynarec_block_t* blockcache; // The current image's
+    rsp_ucode_image_t images[RSP_NUM_UCODE_IMAGES];
 } rsp_dynarec_t;
 
 rsp_dynarec_t* rsp_dynarec_init(u8* codecache, size_t codecache_size);
 int rsp_dynarec_step();
 int rsp_missing_block_handler();
+void rsp_dynarec_select_image();
+void rsp_dynarec_reset_images();
 
 #endif //N64_RSP_DYNAREC_H
@@ -6,6 +6,7 @@
 #include <math.h>
 
 #include "r4300i_register_access.h"
+#include "mips_instructions.h"
 
 #ifdef N64_WIN
 #define ORDERED_S(fs, ft) do { if (isnan(fs) || isnan(ft)) { logfatal("we got some nans, time to panic"); } } while (0)
@@ -728,7 +729,7 @@ MIPS_INSTR(mips_cp_neg_d) {
     set_fpu_register_double(instruction.fr.fd, -value);
 }
 
-MIPS_INSTR(mips_ldc1) {
+MIPS_FPU_MODE_INSTR(mips_ldc1) {
     checkcp1;
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
@@ -737,23 +738,23 @@ MIPS_INSTR(mips_ldc1) {
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
         u64 value = n64_read_physical_dword(physical);
-        set_fpu_register_dword(instruction.i.rt, value);
+        set_fpu_register_dword_fr(instruction.i.rt, value, fr);
     }
 }
 
-MIPS_INSTR(mips_sdc1) {
+MIPS_FPU_MODE_INSTR(mips_sdc1) {
     checkcp1;
     s16 offset  = instruction.fi.offset;
     u64 address = get_register(instruction.fi.base) + offset;
-    u64 value   = get_fpu_register_dword(instruction.fi.ft);
+    u64 value   = get_fpu_register_dword_fr(instruction.fi.ft, fr);
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
     } else {
@@ -761,28 +762,34 @@ MIPS_INSTR(mips_sdc1) {
     }
 }
 
-MIPS_INSTR(mips_lwc1) {
+MIPS_FPU_MODE_INSTR(mips_lwc1) {
     checkcp1;
     s16 offset  = instruction.fi.offset;
     u64 address = get_register(instruction.fi.base) + offset;
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
         u32 value = n64_read_physical_word(physical);
-        set_fpu_register_word(instruction.fi.ft, value);
+        set_fpu_register_word_fr(instruction.fi.ft, value, fr);
     }
 }
 
-MIPS_INSTR(mips_swc1) {
+MIPS_FPU_MODE_INSTR(mips_swc1) {
     checkcp1;
     s16 offset  = instruction.fi.offset;
     u64 address = get_register(instruction.fi.base) + offset;
-    u32 value    = get_fpu_register_word(instruction.fi.ft);
+    u32 value    = get_fpu_register_word_fr(instruction.fi.ft, fr);
 
-    n64_write_word(address, value);
+    u32 physical;
+    if (!resolve_virtual_address_in_mode(address, BUS_STORE, &physical, mode)) {
+        on_tlb_exception(address);
+        r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
+    } else {
+        n64_write_physical_word(physical, value);
+    }
 }
 
 MIPS_INSTR(mips_cp1_invalid) {
@@ -6,6 +6,20 @@
 #define check_signed_overflow_add(op1, op2, res)  (((~((op1) ^ (op2)) & ((op1) ^ (res))) >> ((sizeof(res) * 8) - 1)) & 1)
 #define check_signed_overflow_sub(op1, op2, res) (((((op1) ^ (op2)) & ((op1) ^ (res))) >> ((sizeof(res) * 8) - 1)) & 1)
 #define check_address_error(mask, virtual) (((!N64CP0.is_64bit_addressing) && (s32)(virtual) != (virtual)) || (((virtual) & (mask)) != 0))
+#define check_address_error_in_mode(mask, virtual, mode) (((!addressing_mode_is_64bit(mode)) && (s32)(virtual) != (virtual)) || (((virtual) & (mask)) != 0))
+
+INLINE bool addressing_mode_is_64bit(r4300i_addressing_mode_t mode) {
+    switch (mode) {
+        case ADDRESSING_MODE_KERNEL_64:
+        case ADDRESSING_MODE_USER_64:
+            return true;
+        case ADDRESSING_MODE_KERNEL_32:
+        case ADDRESSING_MODE_USER_32:
+            return false;
+        default:
+            return N64CP0.is_64bit_addressing;
+    }
+}
 
 // https://stackoverflow.com/questions/25095741/how-can-i-multiply-64-bit-operands-and-get-128-bit-result-portably/58381061#58381061
 /* Prevents a partial vectorization from GCC. */
@@ -241,17 +255,17 @@ MIPS_INSTR(mips_dmtc0) {
     set_cp0_register_dword(instruction.r.rd, value);
 }
 
-MIPS_INSTR(mips_ld) {
+MIPS_MODE_INSTR(mips_ld) {
     s16 offset = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
-    if (check_address_error(0b111, address)) {
+    if (check_address_error_in_mode(0b111, address, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, EXCEPTION_ADDRESS_ERROR_LOAD, 0);
         return;
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -269,12 +283,12 @@ MIPS_INSTR(mips_lui) {
     set_register(instruction.i.rt, value);
 }
 
-MIPS_INSTR(mips_lbu) {
+MIPS_MODE_INSTR(mips_lbu) {
     s16 offset = instruction.i.immediate;
     logtrace("LBU offset: %d", offset);
     u64 address = get_register(instruction.i.rs) + offset;
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -283,7 +297,7 @@ MIPS_INSTR(mips_lbu) {
     }
 }
 
-MIPS_INSTR(mips_lhu) {
+MIPS_MODE_INSTR(mips_lhu) {
     s16 offset = instruction.i.immediate;
     logtrace("LHU offset: %d", offset);
     u64 address = get_register(instruction.i.rs) + offset;
@@ -292,7 +306,7 @@ MIPS_INSTR(mips_lhu) {
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -301,7 +315,7 @@ MIPS_INSTR(mips_lhu) {
     }
 }
 
-MIPS_INSTR(mips_lh) {
+MIPS_MODE_INSTR(mips_lh) {
     s16 offset = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
     if ((address & 0b1) > 0) {
@@ -309,7 +323,7 @@ MIPS_INSTR(mips_lh) {
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -318,17 +332,17 @@ MIPS_INSTR(mips_lh) {
     }
 }
 
-MIPS_INSTR(mips_lw) {
+MIPS_MODE_INSTR(mips_lw) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
-    if (check_address_error(0b11, address)) {
+    if (check_address_error_in_mode(0b11, address, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, EXCEPTION_ADDRESS_ERROR_LOAD, 0);
         return;
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -337,7 +351,7 @@ MIPS_INSTR(mips_lw) {
     }
 }
 
-MIPS_INSTR(mips_lwu) {
+MIPS_MODE_INSTR(mips_lwu) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
     if ((address & 0b11) > 0) {
@@ -345,7 +359,7 @@ MIPS_INSTR(mips_lwu) {
     }
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
@@ -354,14 +368,14 @@ MIPS_INSTR(mips_lwu) {
     }
 }
 
-MIPS_INSTR(mips_sb) {
+MIPS_MODE_INSTR(mips_sb) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs);
     address += offset;
     u32 value = get_register(instruction.i.rt); // A larger value is needed in some cases due to bus weirdness
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_STORE, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_STORE, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
     } else {
@@ -369,13 +383,13 @@ MIPS_INSTR(mips_sb) {
     }
 }
 
-MIPS_INSTR(mips_sh) {
+MIPS_MODE_INSTR(mips_sh) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs);
     address += offset;
     u32 value = get_register(instruction.i.rt); // A larger value is needed in some cases due to bus weirdness
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_STORE, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_STORE, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
     } else {
@@ -383,19 +397,19 @@ MIPS_INSTR(mips_sh) {
     }
 }
 
-MIPS_INSTR(mips_sw) {
+MIPS_MODE_INSTR(mips_sw) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs);
     address += offset;
     u32 physical;
 
-    if (check_address_error(0b11, address)) {
+    if (check_address_error_in_mode(0b11, address, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, EXCEPTION_ADDRESS_ERROR_STORE, 0);
         return;
     }
 
-    if (!resolve_virtual_address(address, BUS_STORE, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_STORE, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
     } else {
@@ -403,19 +417,19 @@ MIPS_INSTR(mips_sw) {
     }
 }
 
-MIPS_INSTR(mips_sd) {
+MIPS_MODE_INSTR(mips_sd) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
     u64 value = get_register(instruction.i.rt);
 
     u32 physical;
-    if (check_address_error(0b111, address)) {
+    if (check_address_error_in_mode(0b111, address, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, EXCEPTION_ADDRESS_ERROR_STORE, 0);
         return;
     }
 
-    if (!resolve_virtual_address(address, BUS_STORE, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_STORE, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_STORE), 0);
     } else {
@@ -438,12 +452,12 @@ MIPS_INSTR(mips_daddiu) {
     set_register(instruction.i.rt, result);
 }
 
-MIPS_INSTR(mips_lb) {
+MIPS_MODE_INSTR(mips_lb) {
     s16 offset  = instruction.i.immediate;
     u64 address = get_register(instruction.i.rs) + offset;
 
     u32 physical;
-    if (!resolve_virtual_address(address, BUS_LOAD, &physical)) {
+    if (!resolve_virtual_address_in_mode(address, BUS_LOAD, &physical, mode)) {
         on_tlb_exception(address);
         r4300i_handle_exception(N64CPU.prev_pc, get_tlb_exception_code(N64CP0.tlb_error, BUS_LOAD), 0);
     } else {
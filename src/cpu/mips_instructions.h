@@ -5,6 +5,45 @@
 
 #define MIPS_INSTR(NAME) void NAME(mips_instruction_t instruction)
 
+// Instructions that depend on the addressing mode are written once against it, and instantiated for every mode so the
+// checks fold away. The plain name looks the mode up when it runs, for the dynarec and for supervisor mode.
+#define MIPS_MODE_INSTR_DECL(NAME) \
+    MIPS_INSTR(NAME); \
+    MIPS_INSTR(NAME##_kernel_32); \
+    MIPS_INSTR(NAME##_kernel_64); \
+    MIPS_INSTR(NAME##_user_32); \
+    MIPS_INSTR(NAME##_user_64)
+
+#define MIPS_MODE_INSTR(NAME) \
+    INLINE void NAME##_in_mode(mips_instruction_t instruction, r4300i_addressing_mode_t mode); \
+    MIPS_INSTR(NAME) { NAME##_in_mode(instruction, N64CP0.addressing_mode); } \
+    MIPS_INSTR(NAME##_kernel_32) { NAME##_in_mode(instruction, ADDRESSING_MODE_KERNEL_32); } \
+    MIPS_INSTR(NAME##_kernel_64) { NAME##_in_mode(instruction, ADDRESSING_MODE_KERNEL_64); } \
+    MIPS_INSTR(NAME##_user_32) { NAME##_in_mode(instruction, ADDRESSING_MODE_USER_32); } \
+    MIPS_INSTR(NAME##_user_64) { NAME##_in_mode(instruction, ADDRESSING_MODE_USER_64); } \
+    INLINE void NAME##_in_mode(mips_instruction_t instruction, r4300i_addressing_mode_t mode)
+
+// Same again for the FPU loads and stores, which also depend on the FR bit
+#define MIPS_FPU_MODE_INSTR_DECL(NAME) \
+    MIPS_INSTR(NAME); \
+    MIPS_INSTR(NAME##_kernel_32_fr0); MIPS_INSTR(NAME##_kernel_32_fr1); \
+    MIPS_INSTR(NAME##_kernel_64_fr0); MIPS_INSTR(NAME##_kernel_64_fr1); \
+    MIPS_INSTR(NAME##_user_32_fr0); MIPS_INSTR(NAME##_user_32_fr1); \
+    MIPS_INSTR(NAME##_user_64_fr0); MIPS_INSTR(NAME##_user_64_fr1)
+
+#define MIPS_FPU_MODE_VARIANT(NAME, SUFFIX, MODE) \
+    MIPS_INSTR(NAME##_##SUFFIX##_fr0) { NAME##_in_mode(instruction, MODE, false); } \
+    MIPS_INSTR(NAME##_##SUFFIX##_fr1) { NAME##_in_mode(instruction, MODE, true); }
+
+#define MIPS_FPU_MODE_INSTR(NAME) \
+    INLINE void NAME##_in_mode(mips_instruction_t instruction, r4300i_addressing_mode_t mode, bool fr); \
+    MIPS_INSTR(NAME) { NAME##_in_mode(instruction, N64CP0.addressing_mode, N64CPU.cp0.status.fr); } \
+    MIPS_FPU_MODE_VARIANT(NAME, kernel_32, ADDRESSING_MODE_KERNEL_32) \
+    MIPS_FPU_MODE_VARIANT(NAME, kernel_64, ADDRESSING_MODE_KERNEL_64) \
+    MIPS_FPU_MODE_VARIANT(NAME, user_32, ADDRESSING_MODE_USER_32) \
+    MIPS_FPU_MODE_VARIANT(NAME, user_64, ADDRESSING_MODE_USER_64) \
+    INLINE void NAME##_in_mode(mips_instruction_t instruction, r4300i_addressing_mode_t mode, bool fr)
+
 MIPS_INSTR(mips_nop);
 
 MIPS_INSTR(mips_addi);
@@ -38,28 +77,28 @@ MIPS_INSTR(mips_dmtc0);
 
 MIPS_INSTR(mips_eret);
 
-MIPS_INSTR(mips_ld);
+MIPS_MODE_INSTR_DECL(mips_ld);
 MIPS_INSTR(mips_lui);
-MIPS_INSTR(mips_lbu);
-MIPS_INSTR(mips_lhu);
-MIPS_INSTR(mips_lh);
-MIPS_INSTR(mips_lw);
-MIPS_INSTR(mips_lwu);
-MIPS_INSTR(mips_sb);
-MIPS_INSTR(mips_sh);
-MIPS_INSTR(mips_sd);
-MIPS_INSTR(mips_sw);
+MIPS_MODE_INSTR_DECL(mips_lbu);
+MIPS_MODE_INSTR_DECL(mips_lhu);
+MIPS_MODE_INSTR_DECL(mips_lh);
+MIPS_MODE_INSTR_DECL(mips_lw);
+MIPS_MODE_INSTR_DECL(mips_lwu);
+MIPS_MODE_INSTR_DECL(mips_sb);
+MIPS_MODE_INSTR_DECL(mips_sh);
+MIPS_MODE_INSTR_DECL(mips_sd);
+MIPS_MODE_INSTR_DECL(mips_sw);
 MIPS_INSTR(mips_ori);
 
 MIPS_INSTR(mips_xori);
 MIPS_INSTR(mips_daddiu);
 
-MIPS_INSTR(mips_lb);
+MIPS_MODE_INSTR_DECL(mips_lb);
 
-MIPS_INSTR(mips_ldc1);
-MIPS_INSTR(mips_sdc1);
-MIPS_INSTR(mips_lwc1);
-MIPS_INSTR(mips_swc1);
+MIPS_FPU_MODE_INSTR_DECL(mips_ldc1);
+MIPS_FPU_MODE_INSTR_DECL(mips_sdc1);
+MIPS_FPU_MODE_INSTR_DECL(mips_lwc1);
+MIPS_FPU_MODE_INSTR_DECL(mips_swc1);
 MIPS_INSTR(mips_lwl);
 MIPS_INSTR(mips_lwr);
 MIPS_INSTR(mips_swl);
@@ -6,6 +6,7 @@
 #include "mips_instructions.h"
 #include "fpu_instructions.h"
 #include "tlb_instructions.h"
+#include "r4300i_register_access.h"
 
 const char* register_names[] = {
         "zero", // 0
@@ -48,7 +49,7 @@ const char* cp0_register_names[] = {
         "23", "24", "25", "Parity Error", "Cache Error", "TagLo", "TagHi", "error_epc", "r31"
 };
 
-r4300i_t n64cpu;
+r4300i_t n64cpu __attribute__((aligned(64)));
 
 INLINE bool is_xtlb(u64 address) {
     u8 region = (address >> 62) & 3;
@@ -633,6 +634,37 @@ INLINE mipsinstr_handler_t r4300i_regimm_decode(u64 pc, mips_instruction_t instr
     }
 }
 
+#define MODE_HANDLERS(MODE, FR) { \
+    [OPC_LB]   = mips_lb_##MODE, \
+    [OPC_LBU]  = mips_lbu_##MODE, \
+    [OPC_LH]   = mips_lh_##MODE, \
+    [OPC_LHU]  = mips_lhu_##MODE, \
+    [OPC_LW]   = mips_lw_##MODE, \
+    [OPC_LWU]  = mips_lwu_##MODE, \
+    [OPC_LD]   = mips_ld_##MODE, \
+    [OPC_SB]   = mips_sb_##MODE, \
+    [OPC_SH]   = mips_sh_##MODE, \
+    [OPC_SW]   = mips_sw_##MODE, \
+    [OPC_SD]   = mips_sd_##MODE, \
+    [OPC_LWC1] = mips_lwc1_##MODE##_##FR, \
+    [OPC_LDC1] = mips_ldc1_##MODE##_##FR, \
+    [OPC_SWC1] = mips_swc1_##MODE##_##FR, \
+    [OPC_SDC1] = mips_sdc1_##MODE##_##FR, \
+}
+
+// Indexed by N64CP0.handler_mode, which only changes when CP0 Status does. Supervisor mode rows are left empty, so
+// everything there decodes to the general handlers below.
+const mipsinstr_handler_t r4300i_mode_handlers[R4300I_NUM_HANDLER_MODES][64] = {
+        [ADDRESSING_MODE_KERNEL_32 * 2]     = MODE_HANDLERS(kernel_32, fr0),
+        [ADDRESSING_MODE_KERNEL_32 * 2 + 1] = MODE_HANDLERS(kernel_32, fr1),
+        [ADDRESSING_MODE_KERNEL_64 * 2]     = MODE_HANDLERS(kernel_64, fr0),
+        [ADDRESSING_MODE_KERNEL_64 * 2 + 1] = MODE_HANDLERS(kernel_64, fr1),
+        [ADDRESSING_MODE_USER_32 * 2]       = MODE_HANDLERS(user_32, fr0),
+        [ADDRESSING_MODE_USER_32 * 2 + 1]   = MODE_HANDLERS(user_32, fr1),
+        [ADDRESSING_MODE_USER_64 * 2]       = MODE_HANDLERS(user_64, fr0),
+        [ADDRESSING_MODE_USER_64 * 2 + 1]   = MODE_HANDLERS(user_64, fr1),
+};
+
 mipsinstr_handler_t r4300i_instruction_decode(u64 pc, mips_instruction_t instr) {
 #ifdef LOG_ENABLED
     char buf[50];
@@ -644,6 +676,10 @@ mipsinstr_handler_t r4300i_instruction_decode(u64 pc, mips_instruction_t instr)
     if (unlikely(instr.raw == 0)) {
         return mips_nop;
     }
+    mipsinstr_handler_t mode_handler = r4300i_mode_handlers[N64CP0.handler_mode][instr.op];
+    if (mode_handler != NULL) {
+        return mode_handler;
+    }
     switch (instr.op) {
         case OPC_CP0:    return r4300i_cp0_decode(pc, instr);
         case OPC_CP1:    return r4300i_cp1_decode(pc, instr);
@@ -728,15 +764,26 @@ void on_tlb_exception(u64 address) {
     N64CP0.entry_hi.r = (address >> 62) & 0b11;
 }
 
-void r4300i_step() {
-    N64CPU.cp0.count += CYCLES_PER_INSTR;
-    N64CPU.cp0.count &= 0x1FFFFFFFF;
-    if (unlikely(N64CPU.cp0.count == (u64)N64CPU.cp0.compare << 1)) {
-        N64CPU.cp0.cause.ip7 = true;
-        loginfo("Compare interrupt! count = 0x%09lX compare << 1 = 0x%09lX", N64CP0.count, (u64)N64CP0.compare << 1);
-        r4300i_interrupt_update();
+// Count ticks once every 2 cycles, and the compare interrupt fires when it reaches Compare.
+// Has to be called whenever either of them is written.
+void r4300i_schedule_compare_interrupt() {
+    u64 cycles_until = (((u64)N64CP0.compare << 1) - get_cp0_count_cycles()) & 0x1FFFFFFFF;
+    if (cycles_until == 0) {
+        // Just got there, next time will be after Count wraps around
+        cycles_until = 0x200000000;
     }
+    scheduler_remove_event(SCHEDULER_COMPARE_INTERRUPT);
+    scheduler_enqueue_relative(cycles_until, SCHEDULER_COMPARE_INTERRUPT);
+}
 
+void r4300i_on_compare_interrupt() {
+    N64CP0.cause.ip7 = true;
+    loginfo("Compare interrupt! count = 0x%08X compare = 0x%08X", get_cp0_count(), N64CP0.compare);
+    r4300i_interrupt_update();
+    r4300i_schedule_compare_interrupt();
+}
+
+void r4300i_step() {
     /* Commented out for now since the game never actually reads cp0.random
     if (N64CPU.cp0.random <= N64CPU.cp0.wired) {
         N64CPU.cp0.random = 31;
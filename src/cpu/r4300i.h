@@ -478,7 +478,30 @@ static inline u32 get_tlb_exception_code(tlb_error_t error, bus_access_t bus_acc
     }
 }
 
+// Which of resolve_virtual_address()'s cases the CPU is in. Supervisor mode isn't specialised for.
+typedef enum r4300i_addressing_mode {
+    ADDRESSING_MODE_KERNEL_32,
+    ADDRESSING_MODE_KERNEL_64,
+    ADDRESSING_MODE_USER_32,
+    ADDRESSING_MODE_USER_64,
+    ADDRESSING_MODE_SUPERVISOR,
+    NUM_ADDRESSING_MODES
+} r4300i_addressing_mode_t;
+
+// One set of interpreter handlers per addressing mode and value of the FR bit
+#define R4300I_NUM_HANDLER_MODES (NUM_ADDRESSING_MODES * 2)
+
 typedef struct cp0 {
+    // Worked out from status by cp0_status_updated(). The interpreter looks at these on every memory access.
+    bool kernel_mode;
+    bool supervisor_mode;
+    bool user_mode;
+    bool is_64bit_addressing;
+    r4300i_addressing_mode_t addressing_mode;
+    int handler_mode; // Row of r4300i_mode_handlers the interpreter decodes with
+
+    cp0_status_t status;
+    cp0_cause_t cause;
     u32 index;
     u32 random;
     cp0_entry_lo_t entry_lo0;
@@ -487,11 +510,9 @@ typedef struct cp0 {
     cp0_page_mask_t page_mask;
     u32 wired;
     u64 bad_vaddr;
-    u64 count;
+    u64 count_base; // Count is worked out from this and the scheduler's cycle counter when it's read, see get_cp0_count()
     cp0_entry_hi_t entry_hi;
     u32 compare;
-    cp0_status_t status;
-    cp0_cause_t cause;
     u64 EPC;
     u32 PRId;
     u32 config;
@@ -507,13 +528,9 @@ typedef struct cp0 {
 
     u64 open_bus; // Last value written to any COP0 register
 
-    tlb_entry_t    tlb[32];
+    // Only used by TLB instructions and misses, out of the way at the end
     tlb_error_t tlb_error;
-
-    bool kernel_mode;
-    bool supervisor_mode;
-    bool user_mode;
-    bool is_64bit_addressing;
+    tlb_entry_t    tlb[32];
 } cp0_t;
 
 typedef union fcr0 {
@@ -567,13 +584,27 @@ typedef union fgr {
 
 ASSERTDWORD(fgr_t);
 
+// Laid out hot to cold. Everything the JIT reaches through its state register, and the interpreter touches on every
+// instruction, is in the first cache line, so those accesses use 8 bit displacements. The GPRs come straight after,
+// and the FPU and CP0 state (with the TLB right at the end) after that.
 typedef struct r4300i {
-    u64 gpr[32];
-
     u64 pc;
     u64 next_pc;
     u64 prev_pc;
 
+    // In a branch delay slot?
+    bool branch;
+    bool prev_branch;
+    bool branch_likely_taken;
+
+    // Did an exception just happen?
+    bool exception;
+
+    // Cached value of `cp0.cause.interrupt_pending & cp0.status.im`
+    u8 interrupts;
+
+    u64 gpr[32];
+
     u64 mult_hi;
     u64 mult_lo;
 
@@ -584,32 +615,43 @@ typedef struct r4300i {
 
     fgr_t f[32];
 
-    cp0_t cp0;
     u64 cp2_latch;
 
-    // Cached value of `cp0.cause.interrupt_pending & cp0.status.im`
-    u8 interrupts;
-
-    // In a branch delay slot?
-    bool branch;
-    bool prev_branch;
-    bool branch_likely_taken;
-
-    // Did an exception just happen?
-    bool exception;
+    cp0_t cp0;
 } r4300i_t;
 
+// Compiled code reaches these through cpuState, with an 8-bit displacement as long as they're in the first 128 bytes.
+// That covers the flags and the low GPRs, the GPRs past that get a 32-bit displacement.
+#define R4300I_HOT_BYTES 128
+ASSERTWITHIN(r4300i_t, pc, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, next_pc, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, prev_pc, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, branch, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, prev_branch, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, branch_likely_taken, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, exception, R4300I_HOT_BYTES);
+ASSERTWITHIN(r4300i_t, interrupts, R4300I_HOT_BYTES);
+// The GPRs follow the flags straight away, so as many of them as possible land in the first 128 bytes
+ASSERTWITHIN(r4300i_t, gpr[11], R4300I_HOT_BYTES);
+// The derived mode fields lead cp0_t, keep them ahead of the TLB
+ASSERTWITHIN(cp0_t, handler_mode, offsetof(cp0_t, tlb));
+
 extern r4300i_t n64cpu;
 #define N64CPU n64cpu
 #define N64CP0 N64CPU.cp0
 
 typedef void(*mipsinstr_handler_t)(mips_instruction_t);
 
+// Handlers specialised for each handler mode, by primary opcode. NULL where the opcode has no specialised version.
+extern const mipsinstr_handler_t r4300i_mode_handlers[R4300I_NUM_HANDLER_MODES][64];
+
 void on_tlb_exception(u64 address);
 void r4300i_step();
 void r4300i_handle_exception(u64 pc, u32 code, int coprocessor_error);
 mipsinstr_handler_t r4300i_instruction_decode(u64 pc, mips_instruction_t instr);
 void r4300i_interrupt_update();
+void r4300i_schedule_compare_interrupt();
+void r4300i_on_compare_interrupt();
 bool instruction_stable(mips_instruction_t instr);
 
 extern const char* register_names[];
@@ -637,6 +679,15 @@ INLINE void cp0_status_updated() {
             (N64CPU.cp0.kernel_mode && N64CPU.cp0.status.kx)
             || (N64CPU.cp0.supervisor_mode && N64CPU.cp0.status.sx)
                || (N64CPU.cp0.user_mode && N64CPU.cp0.status.ux);
+
+    if (N64CPU.cp0.kernel_mode) {
+        N64CPU.cp0.addressing_mode = N64CPU.cp0.is_64bit_addressing ? ADDRESSING_MODE_KERNEL_64 : ADDRESSING_MODE_KERNEL_32;
+    } else if (N64CPU.cp0.user_mode) {
+        N64CPU.cp0.addressing_mode = N64CPU.cp0.is_64bit_addressing ? ADDRESSING_MODE_USER_64 : ADDRESSING_MODE_USER_32;
+    } else {
+        N64CPU.cp0.addressing_mode = ADDRESSING_MODE_SUPERVISOR;
+    }
+    N64CPU.cp0.handler_mode = N64CPU.cp0.addressing_mode * 2 + N64CPU.cp0.status.fr;
 }
 
 #define checkcp1 do { if (!N64CPU.cp0.status.cu1) { r4300i_handle_exception(N64CPU.prev_pc, EXCEPTION_COPROCESSOR_UNUSABLE, 1); return; } } while(0)
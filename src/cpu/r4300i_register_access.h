@@ -2,6 +2,17 @@
 #define N64_R4300I_REGISTER_ACCESS_H
 
 #include "r4300i.h"
+#include <system/scheduler.h>
+
+// Count in CPU cycles rather than Count ticks, 33 bits
+INLINE u64 get_cp0_count_cycles() {
+    return (N64CP0.count_base + scheduler_ticks) & 0x1FFFFFFFF;
+}
+
+INLINE u32 get_cp0_count() {
+    u64 shifted = get_cp0_count_cycles() >> 1;
+    return (u32)shifted;
+}
 
 INLINE void set_register(u8 r, u64 value) {
     logtrace("Setting $%s (r%d) to [0x%016lX]", register_names[r], r, value);
@@ -43,7 +54,8 @@ INLINE void set_cp0_register_word(u8 r, u32 value) {
         case R4300I_CP0_REG_RANDOM:
             break;
         case R4300I_CP0_REG_COUNT:
-            N64CPU.cp0.count = (u64)value << 1;
+            N64CPU.cp0.count_base = ((u64)value << 1) - scheduler_ticks;
+            r4300i_schedule_compare_interrupt();
             break;
         case R4300I_CP0_REG_CAUSE: {
             cp0_cause_t newcause;
@@ -59,9 +71,10 @@ INLINE void set_cp0_register_word(u8 r, u32 value) {
             N64CPU.cp0.tag_hi = value;
             break;
         case R4300I_CP0_REG_COMPARE:
-            loginfo("$Compare written with 0x%08X (count is now 0x%08lX)", value, N64CPU.cp0.count);
+            loginfo("$Compare written with 0x%08X (count is now 0x%08X)", value, get_cp0_count());
             N64CPU.cp0.cause.ip7 = false;
             N64CPU.cp0.compare = value;
+            r4300i_schedule_compare_interrupt();
             break;
         case R4300I_CP0_REG_STATUS: {
             N64CPU.cp0.status.raw &= ~CP0_STATUS_WRITE_MASK;
@@ -140,11 +153,6 @@ INLINE void set_cp0_register_word(u8 r, u32 value) {
     loginfo("CP0 $%s = 0x%08X", cp0_register_names[r], value);
 }
 
-INLINE u32 get_cp0_count() {
-    u64 shifted = N64CPU.cp0.count >> 1;
-    return (u32)shifted;
-}
-
 INLINE u32 get_cp0_wired() {
     return N64CP0.wired & 0b111111;
 }
@@ -269,6 +277,7 @@ INLINE void set_cp0_register_dword(u8 r, u64 value) {
             logfatal("Writing CP0 register R4300I_CP0_REG_COMPARE as dword!");
         case R4300I_CP0_REG_STATUS:
             N64CP0.status.raw = value;
+            cp0_status_updated();
         case R4300I_CP0_REG_CAUSE: {
             cp0_cause_t newcause;
             newcause.raw = value;
@@ -392,8 +401,10 @@ INLINE u64 get_cp0_register_dword(u8 r) {
     }
 }
 
-INLINE void set_fpu_register_dword(u8 r, u64 value) {
-    if (!N64CPU.cp0.status.fr) {
+// The _fr versions take the FR bit as an argument, for handlers that were specialised for it
+
+INLINE void set_fpu_register_dword_fr(u8 r, u64 value, bool fr) {
+    if (!fr) {
         // When this bit is not set, accessing odd registers is not allowed.
         r &= ~1;
     }
@@ -401,8 +412,8 @@ INLINE void set_fpu_register_dword(u8 r, u64 value) {
     N64CPU.f[r].raw = value;
 }
 
-INLINE u64 get_fpu_register_dword(u8 r) {
-    if (!N64CPU.cp0.status.fr) {
+INLINE u64 get_fpu_register_dword_fr(u8 r, bool fr) {
+    if (!fr) {
         // When this bit is not set, accessing odd registers is not allowed.
         r &= ~1;
     }
@@ -410,8 +421,8 @@ INLINE u64 get_fpu_register_dword(u8 r) {
     return N64CPU.f[r].raw;
 }
 
-INLINE void set_fpu_register_word(u8 r, u32 value) {
-    if (N64CPU.cp0.status.fr) {
+INLINE void set_fpu_register_word_fr(u8 r, u32 value, bool fr) {
+    if (fr) {
         N64CPU.f[r].lo = value;
     } else {
         if (r & 1) {
@@ -422,8 +433,8 @@ INLINE void set_fpu_register_word(u8 r, u32 value) {
     }
 }
 
-INLINE u32 get_fpu_register_word(u8 r) {
-    if (N64CPU.cp0.status.fr) {
+INLINE u32 get_fpu_register_word_fr(u8 r, bool fr) {
+    if (fr) {
         return N64CPU.f[r].lo;
     } else {
         if (r & 1) {
@@ -434,6 +445,22 @@ INLINE u32 get_fpu_register_word(u8 r) {
     }
 }
 
+INLINE void set_fpu_register_dword(u8 r, u64 value) {
+    set_fpu_register_dword_fr(r, value, N64CPU.cp0.status.fr);
+}
+
+INLINE u64 get_fpu_register_dword(u8 r) {
+    return get_fpu_register_dword_fr(r, N64CPU.cp0.status.fr);
+}
+
+INLINE void set_fpu_register_word(u8 r, u32 value) {
+    set_fpu_register_word_fr(r, value, N64CPU.cp0.status.fr);
+}
+
+INLINE u32 get_fpu_register_word(u8 r) {
+    return get_fpu_register_word_fr(r, N64CPU.cp0.status.fr);
+}
+
 INLINE void set_fpu_register_double(u8 r, double value) {
     _Static_assert(sizeof(double) == sizeof(u64), "double and dword need to both be 64 bits for this to work.");
 
@@ -10,9 +10,11 @@
 #include <mem/n64bus.h>
 #include <cpu/dynarec/dynarec.h>
 #include <mem/mem_util.h>
+#include <system/rsp_thread.h>
 
 #include "rsp_types.h"
 #include "rsp_interface.h"
+#include "rsp_profiler.h"
 
 #define RSP_CP0_DMA_CACHE        0
 #define RSP_CP0_DMA_DRAM         1
@@ -130,13 +132,56 @@ INLINE void quick_invalidate_rsp_icache(u32 address) {
 
     N64RSP.icache[index].handler = cache_rsp_instruction;
     N64RSP.icache[index].instruction.raw = word_from_byte_array(N64RSP.sp_imem, address);
-    N64RSPDYNAREC->blockcache[index].run = rsp_missing_block_handler;
+    // Compiled code is kept per IMEM image, so rather than throwing blocks away, look the image up again before running
+    N64RSPDYNAREC->imem_dirty = true;
+}
+
+// Identifies the microcode in IMEM
+INLINE u64 rsp_imem_hash() {
+    // FNV-1a over the instruction words
+    u64 hash = 0xCBF29CE484222325;
+    for (int i = 0; i < SP_IMEM_SIZE / 4; i++) {
+        hash ^= word_from_byte_array(N64RSP.sp_imem, i * 4);
+        hash *= 0x100000001B3;
+    }
+    return hash;
 }
 
 INLINE void invalidate_rsp_icache(u32 address) {
     quick_invalidate_rsp_icache(address & 0xFFC);
 }
 
+// Refreshes every instruction in a span of IMEM, which wraps at the end
+INLINE void invalidate_rsp_icache_range(u32 address, u32 length) {
+    for (u32 i = 0; i < length; i += 4) {
+        quick_invalidate_rsp_icache((address + i) & 0xFFC);
+    }
+}
+
+// Both sides of an RSP DMA are stored a word at a time in host order, so a row is a straight copy. SP memory wraps within
+// its 4KiB, and the DRAM address can run past the end of RDRAM, where there's nothing to read or write.
+INLINE void rsp_dma_copy_row(u8* mem, u32 mem_address, u32 dram_address, u32 length, bool to_mem) {
+    while (length > 0) {
+        u32 span = length;
+        if (span > SP_DMEM_SIZE - mem_address) {
+            span = SP_DMEM_SIZE - mem_address;
+        }
+        u32 in_rdram = 0;
+        if (dram_address < N64_RDRAM_SIZE) {
+            in_rdram = span < N64_RDRAM_SIZE - dram_address ? span : N64_RDRAM_SIZE - dram_address;
+        }
+        if (to_mem) {
+            memcpy(mem + mem_address, n64sys.mem.rdram + dram_address, in_rdram);
+            memset(mem + mem_address + in_rdram, 0, span - in_rdram);
+        } else {
+            memcpy(n64sys.mem.rdram + dram_address, mem + mem_address, in_rdram);
+        }
+        length -= span;
+        mem_address = (mem_address + span) & 0xFFF;
+        dram_address += span;
+    }
+}
+
 INLINE void rsp_dma_read() {
     u32 length = N64RSP.io.dma.length + 1;
 
@@ -154,19 +199,11 @@ INLINE void rsp_dma_read() {
         logwarn("Misaligned MEM RSP DMA READ! (from 0x%08X, aligned to 0x%08X)", mem_addr_reg.address, mem_address);
     }
 
-    for (int i = 0; i < N64RSP.io.dma.count + 1; i++) {
-        u8* mem = (mem_addr_reg.imem ? N64RSP.sp_imem : N64RSP.sp_dmem);
-        u8* rdram = n64sys.mem.rdram + dram_address;
-        for (int j = 0; j < length; j++) {
-            u16 addr = (mem_address + j) & 0xFFF;
-            mem[addr] = rdram[j];
-        }
-
-        if (mem_addr_reg.imem) {
-            for (int j = 0; j < length; j += 4) {
-                quick_invalidate_rsp_icache((mem_address + j) & 0xFFF);
-            }
-        }
+    u8* mem = (mem_addr_reg.imem ? N64RSP.sp_imem : N64RSP.sp_dmem);
+    u32 rows = N64RSP.io.dma.count + 1;
+    u32 mem_start = mem_address;
+    for (int i = 0; i < rows; i++) {
+        rsp_dma_copy_row(mem, mem_address, dram_address, length, true);
 
         int skip = i == N64RSP.io.dma.count ? 0 : N64RSP.io.dma.skip;
 
@@ -176,6 +213,14 @@ INLINE void rsp_dma_read() {
         mem_address &= RSP_MEM_ADDR_MASK;
     }
 
+    rsp_profiler_count_dma(rows * length);
+
+    if (mem_addr_reg.imem) {
+        // The rows are back to back in IMEM, and anything past 4KiB has written over the start again
+        u32 total = rows * length;
+        invalidate_rsp_icache_range(mem_start, total < SP_IMEM_SIZE ? total : SP_IMEM_SIZE);
+    }
+
     // Set registers for reading now that DMA is complete
     N64RSP.io.dram_addr.address = dram_address;
     N64RSP.io.mem_addr.address = mem_address;
@@ -203,19 +248,19 @@ INLINE void rsp_dma_write() {
         logwarn("Misaligned MEM RSP DMA WRITE! 0x%08X", mem_addr.address);
     }
 
+    u8* mem = (mem_addr.imem ? N64RSP.sp_imem : N64RSP.sp_dmem);
     for (int i = 0; i < N64RSP.io.dma.count + 1; i++) {
-        u8* mem = (mem_addr.imem ? N64RSP.sp_imem : N64RSP.sp_dmem);
-        u8* rdram = n64sys.mem.rdram + dram_address;
-        for (int j = 0; j < length; j++) {
-            u16 addr = (mem_address + j) & 0xFFF;
-            rdram[j] = mem[addr];
-        }
-
+        rsp_dma_copy_row(mem, mem_address, dram_address, length, false);
 
         // Invalidate all pages touched by the DMA
         // This is probably unnecessary, since why would someone be copying code from the RSP to the CPU and then executing it?
-        for (int j = 0; j < length; j += BLOCKCACHE_PAGE_SIZE) {
-            invalidate_dynarec_page(dram_address + j);
+        u32 end = dram_address + length < N64_RDRAM_SIZE ? dram_address + length : N64_RDRAM_SIZE;
+        for (u32 page = dram_address & ~(BLOCKCACHE_PAGE_SIZE - 1); page < end; page += BLOCKCACHE_PAGE_SIZE) {
+            if (unlikely(on_rsp_thread)) {
+                rsp_thread_defer_invalidation(page);
+            } else {
+                invalidate_dynarec_page(page);
+            }
         }
 
         int skip = i == N64RSP.io.dma.count ? 0 : N64RSP.io.dma.skip;
@@ -226,6 +271,8 @@ INLINE void rsp_dma_write() {
         mem_address &= RSP_MEM_ADDR_MASK;
     }
 
+    rsp_profiler_count_dma((N64RSP.io.dma.count + 1) * length);
+
     N64RSP.io.dram_addr.address = dram_address;
     N64RSP.io.mem_addr.address = mem_address;
     N64RSP.io.mem_addr.imem = mem_addr.imem;
@@ -409,8 +456,9 @@ INLINE void rsp_set_vce(u16 vce) {
 }
 
 void rsp_step();
-void rsp_run();
-void rsp_dynarec_run();
+// Both return how many steps they ran
+int rsp_run();
+int rsp_dynarec_run();
 vu_reg_t ext_get_vte(vu_reg_t* vt, u8 e);
 
 #endif //N64_RSP_H
@@ -0,0 +1,77 @@
+#include "rsp_hle.h"
+
+#include <log.h>
+#include "rsp.h"
+
+// What the microcode's final break does, plus the task done signal the boot code sets
+static void finish_task() {
+    N64RSP.status.halt = true;
+    N64RSP.status.broke = true;
+    N64RSP.status.signal_2 = true;
+    N64RSP.steps = 0;
+    rsp_profiler_task_end(true);
+
+    if (N64RSP.status.intr_on_break) {
+        interrupt_raise(INTERRUPT_SP);
+    }
+}
+
+static bool try_audio_task() {
+    if (!n64sys.hle_audio) {
+        return false;
+    }
+
+    u32 ucode_data = ostask_field(OSTASK_UCODE_DATA);
+    if (rsp_hle_audio_abi1_matches(ucode_data)) {
+        rsp_hle_audio_abi1_run(ucode_data, ostask_field(OSTASK_UCODE_DATA_SIZE), ostask_field(OSTASK_DATA_PTR), ostask_field(OSTASK_DATA_SIZE));
+        return true;
+    }
+
+    static bool warned = false;
+    if (!warned) {
+        logwarn("Audio task with unrecognised microcode (data at 0x%08X), running it on the RSP", ucode_data);
+        warned = true;
+    }
+    return false;
+}
+
+static bool try_gfx_task() {
+    if (!n64sys.hle_gfx) {
+        return false;
+    }
+
+    // Usually the same microcode every frame, so only look at it again when it moves
+    static u32 last_ucode_data = 0xFFFFFFFF;
+    static rsp_hle_gfx_ucode_t ucode = GFX_UCODE_UNKNOWN;
+    u32 ucode_data = ostask_field(OSTASK_UCODE_DATA);
+    if (ucode_data != last_ucode_data) {
+        last_ucode_data = ucode_data;
+        ucode = rsp_hle_gfx_identify(ucode_data, ostask_field(OSTASK_UCODE_DATA_SIZE));
+        if (ucode == GFX_UCODE_UNKNOWN) {
+            logwarn("Graphics task with unrecognised microcode (data at 0x%08X), running it on the RSP", ucode_data);
+        }
+    }
+
+    if (ucode == GFX_UCODE_UNKNOWN) {
+        return false;
+    }
+    rsp_hle_gfx_run(ucode, ostask_field(OSTASK_DATA_PTR));
+    return true;
+}
+
+bool rsp_hle_try_task() {
+    bool handled = false;
+    switch (ostask_field(OSTASK_TYPE)) {
+        case M_GFXTASK:
+            handled = try_gfx_task();
+            break;
+        case M_AUDTASK:
+            handled = try_audio_task();
+            break;
+    }
+
+    if (handled) {
+        finish_task();
+    }
+    return handled;
+}
@@ -0,0 +1,101 @@
+#ifndef N64_RSP_HLE_H
+#define N64_RSP_HLE_H
+
+#include <stdbool.h>
+#include <util.h>
+#include <log.h>
+#include <mem/mem_util.h>
+#include <mem/n64mem.h>
+#include <system/n64system.h>
+#include "rsp_types.h"
+
+// libultra leaves the OSTask for the RSP at the end of DMEM before starting it
+#define OSTASK_ADDRESS 0xFC0
+#define OSTASK_TYPE            0x00
+#define OSTASK_FLAGS           0x04
+#define OSTASK_UCODE_BOOT      0x08
+#define OSTASK_UCODE_BOOT_SIZE 0x0C
+#define OSTASK_UCODE           0x10
+#define OSTASK_UCODE_SIZE      0x14
+#define OSTASK_UCODE_DATA      0x18
+#define OSTASK_UCODE_DATA_SIZE 0x1C
+#define OSTASK_DRAM_STACK      0x20
+#define OSTASK_DRAM_STACK_SIZE 0x24
+#define OSTASK_OUTPUT_BUFF     0x28
+#define OSTASK_OUTPUT_BUFF_SIZE 0x2C
+#define OSTASK_DATA_PTR        0x30
+#define OSTASK_DATA_SIZE       0x34
+#define OSTASK_YIELD_DATA_PTR  0x38
+#define OSTASK_YIELD_DATA_SIZE 0x3C
+
+#define M_GFXTASK 1
+#define M_AUDTASK 2
+
+extern rsp_t n64rsp;
+
+// Called when the CPU starts the RSP. If the task is one there's a native implementation of, runs it and leaves the RSP
+// the way the microcode's final break would have, and returns true. Otherwise the RSP runs it as usual.
+bool rsp_hle_try_task();
+
+bool rsp_hle_audio_abi1_matches(u32 ucode_data);
+void rsp_hle_audio_abi1_run(u32 ucode_data, u32 ucode_data_size, u32 data_ptr, u32 data_size);
+
+typedef enum rsp_hle_gfx_ucode {
+    GFX_UCODE_UNKNOWN,
+    GFX_UCODE_F3D,
+    GFX_UCODE_F3DEX,
+    GFX_UCODE_F3DEX2
+} rsp_hle_gfx_ucode_t;
+
+rsp_hle_gfx_ucode_t rsp_hle_gfx_identify(u32 ucode_data, u32 ucode_data_size);
+void rsp_hle_gfx_run(rsp_hle_gfx_ucode_t ucode, u32 data_ptr);
+// Where vertex `index` of the last display list ended up: x and y in pixels, z in the RDP's depth units
+void rsp_hle_gfx_vertex_screen(int index, float* screen);
+// Where the graphics HLE sends the RDP commands it builds. rdp_run_hle_command() unless something else needs to see them.
+extern void (*rsp_hle_gfx_rdp_command)(int command_length, u32* buffer);
+
+INLINE u32 ostask_field(int offset) {
+    return word_from_byte_array(n64rsp.sp_dmem, OSTASK_ADDRESS + offset);
+}
+
+// Memory as the microcode would see it. Both DMEM and RDRAM are stored a word at a time in host order.
+
+INLINE u8 hle_dmem_u8(u32 address) {
+    return n64rsp.sp_dmem[BYTE_ADDRESS(address & 0xFFF)];
+}
+
+INLINE s16 hle_dmem_s16(u32 address) {
+    return half_from_byte_array(n64rsp.sp_dmem, HALF_ADDRESS(address & 0xFFE));
+}
+
+INLINE void hle_dmem_write_s16(u32 address, s16 value) {
+    half_to_byte_array(n64rsp.sp_dmem, HALF_ADDRESS(address & 0xFFE), value);
+}
+
+INLINE u8 hle_rdram_u8(u32 address) {
+    return n64sys.mem.rdram[BYTE_ADDRESS(address & (N64_RDRAM_SIZE - 1))];
+}
+
+INLINE u32 hle_rdram_u32(u32 address) {
+    return word_from_byte_array(n64sys.mem.rdram, address & (N64_RDRAM_SIZE - 4));
+}
+
+INLINE void hle_rdram_write_u32(u32 address, u32 value) {
+    word_to_byte_array(n64sys.mem.rdram, address & (N64_RDRAM_SIZE - 4), value);
+}
+
+INLINE s16 hle_rdram_s16(u32 address) {
+    return half_from_byte_array(n64sys.mem.rdram, HALF_ADDRESS(address & (N64_RDRAM_SIZE - 2)));
+}
+
+INLINE void hle_rdram_write_s16(u32 address, s16 value) {
+    half_to_byte_array(n64sys.mem.rdram, HALF_ADDRESS(address & (N64_RDRAM_SIZE - 2)), value);
+}
+
+INLINE s16 hle_clamp_s16(s32 value) {
+    if (value < -32768) return -32768;
+    if (value > 32767) return 32767;
+    return value;
+}
+
+#endif //N64_RSP_HLE_H
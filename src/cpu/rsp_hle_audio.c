@@ -0,0 +1,622 @@
+#include "rsp_hle.h"
+
+#include <string.h>
+#include <math.h>
+#include <log.h>
+#include <cpu/dynarec/dynarec.h>
+#ifdef N64_USE_SIMD
+#include <emmintrin.h>
+#endif
+
+// Native implementation of the standard libultra audio microcode (ABI1). The command list is run directly against DMEM
+// and RDRAM, in the same buffers the microcode would use, so tasks can move between this and the RSP.
+
+// Buffer addresses in commands are relative to this
+#define DMEM_BASE 0x5C0
+#define NUM_SEGMENTS 16
+
+// Flags in the high byte of a command's first word
+#define A_INIT 0x01
+#define A_CONTINUE 0x00
+#define A_LOOP 0x02
+#define A_OUT 0x02
+#define A_LEFT 0x02
+#define A_RIGHT 0x00
+#define A_VOL 0x04
+#define A_RATE 0x00
+#define A_AUX 0x08
+
+#define ALIGN(x, a) (((x) + ((a) - 1)) & ~((a) - 1))
+
+typedef enum abi1_command {
+    A_SPNOOP,
+    A_ADPCM,
+    A_CLEARBUFF,
+    A_ENVMIXER,
+    A_LOADBUFF,
+    A_RESAMPLE,
+    A_SAVEBUFF,
+    A_SEGMENT,
+    A_SETBUFF,
+    A_SETVOL,
+    A_DMEMMOVE,
+    A_LOADADPCM,
+    A_MIXER,
+    A_INTERLEAVE,
+    A_POLEF,
+    A_SETLOOP
+} abi1_command_t;
+
+// Everything the microcode keeps between commands
+static struct {
+    u32 segments[NUM_SEGMENTS];
+
+    u16 in;
+    u16 out;
+    u16 count;
+    u16 dry_right;
+    u16 wet_left;
+    u16 wet_right;
+
+    s16 dry;
+    s16 wet;
+    s16 vol[2];
+    s16 target[2];
+    s32 rate[2];
+
+    u32 loop;
+    s16 table[16 * 16]; // ADPCM codebook. The low nibble of each frame header can select any of 16 entries.
+} state;
+
+// 4 tap filter for each of 64 subsample positions, in Q15. Loaded from the microcode's data segment.
+#define RESAMPLE_LUT_SIZE (64 * 4 * sizeof(s16))
+static s16 resample_lut[64][4];
+static u32 resample_lut_ucode_data = 0xFFFFFFFF;
+
+bool rsp_hle_audio_abi1_matches(u32 ucode_data) {
+    // Words of the microcode's data segment that tell ABI1 apart from its variants
+    return hle_rdram_u32(ucode_data) == 0x00000001
+        && hle_rdram_u32(ucode_data + 0x30) == 0xF0000F00
+        && hle_rdram_u32(ucode_data + 0x28) == 0x1E24138C;
+}
+
+INLINE u32 segmented_address(u32 address) {
+    u8 segment = (address >> 24) & 0x3F;
+    u32 offset = address & 0xFFFFFF;
+    if (segment >= NUM_SEGMENTS) {
+        logwarn("Audio HLE: segment %d out of range", segment);
+        return offset;
+    }
+    return state.segments[segment] + offset;
+}
+
+// Written through to RDRAM the same way an RSP DMA would be
+static void invalidate_written(u32 address, u32 length) {
+    for (u32 page = address & ~(BLOCKCACHE_PAGE_SIZE - 1); page < address + length; page += BLOCKCACHE_PAGE_SIZE) {
+        invalidate_dynarec_page(page);
+    }
+}
+
+static void load(u16 dmem, u32 address, u16 count) {
+    // Both sides stored a word at a time, and the DMA works in 8 byte units, so copying the bytes as they are is fine
+    dmem &= ~3;
+    address &= ~7;
+    count = ALIGN(count, 8);
+    for (int i = 0; i < count; i += 4) {
+        word_to_byte_array(n64rsp.sp_dmem, (dmem + i) & 0xFFC, hle_rdram_u32(address + i));
+    }
+}
+
+static void save(u16 dmem, u32 address, u16 count) {
+    dmem &= ~3;
+    address &= ~7;
+    count = ALIGN(count, 8);
+    for (int i = 0; i < count; i += 4) {
+        hle_rdram_write_u32(address + i, word_from_byte_array(n64rsp.sp_dmem, (dmem + i) & 0xFFC));
+    }
+    invalidate_written(address, count);
+}
+
+static void clear(u16 dmem, u16 count) {
+    for (int i = 0; i < count; i += 2) {
+        hle_dmem_write_s16(dmem + i, 0);
+    }
+}
+
+static void move(u16 dmemo, u16 dmemi, u16 count) {
+    for (int i = 0; i < count; i++) {
+        n64rsp.sp_dmem[BYTE_ADDRESS((dmemo + i) & 0xFFF)] = n64rsp.sp_dmem[BYTE_ADDRESS((dmemi + i) & 0xFFF)];
+    }
+}
+
+// The product is clamped before it's added, since 0x8000 * 0x8000 doesn't fit in 16 bits and the SIMD path can't keep it
+INLINE s16 mix_sample(s16 dst, s16 src, s16 gain) {
+    return hle_clamp_s16(dst + hle_clamp_s16((src * gain) >> 15));
+}
+
+#ifdef N64_USE_SIMD
+// mix_sample() for 8 samples at once
+INLINE __m128i mix_samples(__m128i dst, __m128i src, __m128i gain) {
+    // (src * gain) >> 15, from the high and low halves of the products
+    __m128i hi = _mm_slli_epi16(_mm_mulhi_epi16(src, gain), 1);
+    __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(src, gain), 15);
+    __m128i product = _mm_or_si128(hi, lo);
+    // The only product that comes out as 0x8000 is 0x8000 * 0x8000, which should be 0x8000 positive. Clamp it.
+    product = _mm_add_epi16(product, _mm_cmpeq_epi16(product, _mm_set1_epi16(0x8000)));
+    return _mm_adds_epi16(dst, product);
+}
+#endif
+
+static void mix(u16 dmemo, u16 dmemi, u16 count, s16 gain) {
+    int i = 0;
+#ifdef N64_USE_SIMD
+    // Samples are swapped in pairs in DMEM, but the same way in both buffers, so 16 byte aligned buffers can be mixed
+    // 8 samples at a time without caring. DMEM itself isn't 16 byte aligned in rsp_t, so the loads can't assume it is.
+    if (((dmemo | dmemi) & 0xF) == 0 && dmemo + count <= SP_DMEM_SIZE && dmemi + count <= SP_DMEM_SIZE) {
+        __m128i gains = _mm_set1_epi16(gain);
+        for (; i + 16 <= count; i += 16) {
+            __m128i* dst = (__m128i*)&n64rsp.sp_dmem[dmemo + i];
+            __m128i src = _mm_loadu_si128((__m128i*)&n64rsp.sp_dmem[dmemi + i]);
+            _mm_storeu_si128(dst, mix_samples(_mm_loadu_si128(dst), src, gains));
+        }
+    }
+#endif
+    for (; i < count; i += 2) {
+        hle_dmem_write_s16(dmemo + i, mix_sample(hle_dmem_s16(dmemo + i), hle_dmem_s16(dmemi + i), gain));
+    }
+}
+
+static void interleave(u16 dmemo, u16 left, u16 right, u16 count) {
+    for (int i = 0; i < count / 4; i++) {
+        hle_dmem_write_s16(dmemo + i * 4, hle_dmem_s16(left + i * 2));
+        hle_dmem_write_s16(dmemo + i * 4 + 2, hle_dmem_s16(right + i * 2));
+    }
+}
+
+// Dot product of the first n entries of x with y reversed
+INLINE s32 rdot(int n, const s16* x, const s16* y) {
+    s32 accumulator = 0;
+    for (int i = 0; i < n; i++) {
+        accumulator += x[i] * y[n - 1 - i];
+    }
+    return accumulator;
+}
+
+#ifdef N64_USE_SIMD
+// Adds a * b to 8 32 bit accumulators, kept as the low and high 4
+INLINE void multiply_accumulate(__m128i* lo, __m128i* hi, __m128i a, __m128i b) {
+    __m128i product_lo = _mm_mullo_epi16(a, b);
+    __m128i product_hi = _mm_mulhi_epi16(a, b);
+    *lo = _mm_add_epi32(*lo, _mm_unpacklo_epi16(product_lo, product_hi));
+    *hi = _mm_add_epi32(*hi, _mm_unpackhi_epi16(product_lo, product_hi));
+}
+#endif
+
+// Decodes 8 samples, predicted from the two before them
+static void adpcm_predict(s16* dst, const s16* residuals, const s16* book, s16 last1, s16 last2) {
+    const s16* book1 = book;
+    const s16* book2 = book + 8;
+#ifdef N64_USE_SIMD
+    // Each sample only depends on the residuals and the two samples before the frame, not on the samples decoded
+    // before it in this frame, so all 8 can be worked out at once.
+    __m128i r = _mm_loadu_si128((const __m128i*)residuals);
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    multiply_accumulate(&lo, &hi, r, _mm_set1_epi16(1 << 11));
+    multiply_accumulate(&lo, &hi, _mm_loadu_si128((const __m128i*)book1), _mm_set1_epi16(last1));
+    multiply_accumulate(&lo, &hi, _mm_loadu_si128((const __m128i*)book2), _mm_set1_epi16(last2));
+    // rdot(): sample i gets book2[k] * residuals[i - 1 - k], the residuals shifted up k + 1 places
+#define ADPCM_RDOT_TAP(k) multiply_accumulate(&lo, &hi, _mm_slli_si128(r, ((k) + 1) * 2), _mm_set1_epi16(book2[k]))
+    ADPCM_RDOT_TAP(0);
+    ADPCM_RDOT_TAP(1);
+    ADPCM_RDOT_TAP(2);
+    ADPCM_RDOT_TAP(3);
+    ADPCM_RDOT_TAP(4);
+    ADPCM_RDOT_TAP(5);
+    ADPCM_RDOT_TAP(6);
+#undef ADPCM_RDOT_TAP
+    // Packing with signed saturation is the clamp
+    _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(_mm_srai_epi32(lo, 11), _mm_srai_epi32(hi, 11)));
+#else
+    for (int i = 0; i < 8; i++) {
+        s32 accumulator = (s32)residuals[i] << 11;
+        accumulator += book1[i] * last1 + book2[i] * last2 + rdot(i, book2, residuals);
+        dst[i] = hle_clamp_s16(accumulator >> 11);
+    }
+#endif
+}
+
+static void adpcm(bool init, bool loop, u16 dmemo, u16 dmemi, u16 count, u32 last_frame_address) {
+    s16 last_frame[16];
+    if (init) {
+        memset(last_frame, 0, sizeof(last_frame));
+    } else {
+        u32 address = loop ? state.loop : last_frame_address;
+        for (int i = 0; i < 16; i++) {
+            last_frame[i] = hle_rdram_s16(address + i * 2);
+        }
+    }
+
+    for (int i = 0; i < 16; i++, dmemo += 2) {
+        hle_dmem_write_s16(dmemo, last_frame[i]);
+    }
+
+    // 9 bytes in, 16 samples out
+    for (; count >= 32; count -= 32) {
+        u8 header = hle_dmem_u8(dmemi++);
+        int scale = header >> 4;
+        int rshift = scale < 12 ? 12 - scale : 0;
+        const s16* book = &state.table[(header & 0xF) * 16];
+
+        s16 residuals[16];
+        for (int i = 0; i < 8; i++) {
+            u8 byte = hle_dmem_u8(dmemi++);
+            residuals[i * 2] = (s16)((byte & 0xF0) << 8) >> rshift;
+            residuals[i * 2 + 1] = (s16)((byte & 0x0F) << 12) >> rshift;
+        }
+
+        adpcm_predict(last_frame, residuals, book, last_frame[14], last_frame[15]);
+        adpcm_predict(last_frame + 8, residuals + 8, book, last_frame[6], last_frame[7]);
+
+        for (int i = 0; i < 16; i++, dmemo += 2) {
+            hle_dmem_write_s16(dmemo, last_frame[i]);
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        hle_rdram_write_s16(last_frame_address + i * 2, last_frame[i]);
+    }
+}
+
+// A plausible table: 64 rows that each add up to about 1.0, with the weight moving from the second tap to the third
+static bool is_resample_lut(u32 address) {
+    s16 previous_tap1 = 0x7FFF;
+    s16 previous_tap2 = -0x8000;
+    for (int phase = 0; phase < 64; phase++) {
+        s16 taps[4];
+        s32 sum = 0;
+        for (int tap = 0; tap < 4; tap++) {
+            taps[tap] = hle_rdram_s16(address + (phase * 4 + tap) * 2);
+            sum += taps[tap];
+        }
+        if (sum < 0x7C00 || sum > 0x8400 || taps[1] > previous_tap1 || taps[2] < previous_tap2) {
+            return false;
+        }
+        previous_tap1 = taps[1];
+        previous_tap2 = taps[2];
+    }
+    return previous_tap2 > previous_tap1;
+}
+
+static void build_fallback_resample_lut() {
+    // Catmull-Rom between the middle two of four samples. Close to the microcode's own table, but not the same.
+    for (int phase = 0; phase < 64; phase++) {
+        double t = phase / 64.0;
+        double coefficients[4] = {
+            (-t * t * t + 2 * t * t - t) / 2,
+            (3 * t * t * t - 5 * t * t + 2) / 2,
+            (-3 * t * t * t + 4 * t * t + t) / 2,
+            (t * t * t - t * t) / 2
+        };
+        for (int tap = 0; tap < 4; tap++) {
+            double scaled = round(coefficients[tap] * 32768.0);
+            resample_lut[phase][tap] = scaled > 32767 ? 32767 : (s16)scaled;
+        }
+    }
+}
+
+// The microcode reads the table from its data segment, which the boot code loads into DMEM. It's found by its shape
+// rather than at a fixed offset, the same way libultra functions are matched, and only looked for again when the
+// microcode's data moves.
+static void load_resample_lut(u32 ucode_data, u32 ucode_data_size) {
+    if (ucode_data == resample_lut_ucode_data) {
+        return;
+    }
+    resample_lut_ucode_data = ucode_data;
+
+    for (u32 offset = 0; offset + RESAMPLE_LUT_SIZE <= ucode_data_size; offset += 8) {
+        if (is_resample_lut(ucode_data + offset)) {
+            for (int phase = 0; phase < 64; phase++) {
+                for (int tap = 0; tap < 4; tap++) {
+                    resample_lut[phase][tap] = hle_rdram_s16(ucode_data + offset + (phase * 4 + tap) * 2);
+                }
+            }
+            return;
+        }
+    }
+
+    logwarn("Audio HLE: no resample table in the microcode's data at 0x%08X, resampled voices will sound slightly different", ucode_data);
+    build_fallback_resample_lut();
+}
+
+// One resampled sample. The taps are accumulated with a clamp after each, like mixing.
+INLINE s16 resample_sample(u16 ipos, const s16* lut) {
+    s16 sample = 0;
+    for (int tap = 0; tap < 4; tap++) {
+        sample = mix_sample(sample, hle_dmem_s16(ipos + tap * 2), lut[tap]);
+    }
+    return sample;
+}
+
+static void resample(bool init, u16 dmemo, u16 dmemi, u16 count, u32 pitch, u32 address) {
+    // The four samples before the input are the end of the last call's
+    u16 ipos = dmemi - 8;
+    u32 pitch_accumulator;
+    if (init) {
+        for (int i = 0; i < 4; i++) {
+            hle_dmem_write_s16(ipos + i * 2, 0);
+        }
+        pitch_accumulator = 0;
+    } else {
+        for (int i = 0; i < 4; i++) {
+            hle_dmem_write_s16(ipos + i * 2, hle_rdram_s16(address + i * 2));
+        }
+        pitch_accumulator = (u16)hle_rdram_s16(address + 8);
+    }
+
+    int i = 0;
+#ifdef N64_USE_SIMD
+    // Where each output sample reads from depends on the pitch, so the taps are gathered 8 samples at a time and then
+    // filtered together.
+    for (; i + 16 <= count; i += 16) {
+        s16 samples[4][8];
+        s16 coefficients[4][8];
+        for (int lane = 0; lane < 8; lane++) {
+            const s16* lut = resample_lut[(pitch_accumulator >> 10) & 0x3F];
+            for (int tap = 0; tap < 4; tap++) {
+                samples[tap][lane] = hle_dmem_s16(ipos + tap * 2);
+                coefficients[tap][lane] = lut[tap];
+            }
+            pitch_accumulator += pitch;
+            ipos += (pitch_accumulator >> 16) * 2;
+            pitch_accumulator &= 0xFFFF;
+        }
+
+        __m128i filtered = _mm_setzero_si128();
+        for (int tap = 0; tap < 4; tap++) {
+            filtered = mix_samples(filtered, _mm_loadu_si128((__m128i*)samples[tap]), _mm_loadu_si128((__m128i*)coefficients[tap]));
+        }
+        s16 out[8];
+        _mm_storeu_si128((__m128i*)out, filtered);
+        for (int lane = 0; lane < 8; lane++) {
+            hle_dmem_write_s16(dmemo + i + lane * 2, out[lane]);
+        }
+    }
+#endif
+    for (; i < count; i += 2) {
+        hle_dmem_write_s16(dmemo + i, resample_sample(ipos, resample_lut[(pitch_accumulator >> 10) & 0x3F]));
+
+        pitch_accumulator += pitch;
+        ipos += (pitch_accumulator >> 16) * 2;
+        pitch_accumulator &= 0xFFFF;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        hle_rdram_write_s16(address + i * 2, hle_dmem_s16(ipos + i * 2));
+    }
+    hle_rdram_write_s16(address + 8, pitch_accumulator);
+}
+
+typedef struct ramp {
+    s64 value;
+    s64 step;
+    s64 target;
+} ramp_t;
+
+INLINE s16 ramp_step(ramp_t* ramp) {
+    ramp->value += ramp->step;
+    bool reached = ramp->step <= 0 ? ramp->value <= ramp->target : ramp->value >= ramp->target;
+    if (reached) {
+        ramp->value = ramp->target;
+        ramp->step = 0;
+    }
+    return ramp->value >> 16;
+}
+
+// Only this file reads the state back, so it's laid out however is convenient. 80 bytes, the same as the microcode's.
+#define ENVMIX_STATE_WET 0
+#define ENVMIX_STATE_DRY 4
+#define ENVMIX_STATE_TARGET 8
+#define ENVMIX_STATE_RATE 16
+#define ENVMIX_STATE_SEQUENCE 24
+#define ENVMIX_STATE_VALUE 32
+
+static void envmixer(bool init, bool aux, u32 address) {
+    ramp_t ramps[2];
+    s32 sequence[2];
+    s32 rates[2];
+    s16 dry = state.dry;
+    s16 wet = state.wet;
+
+    if (init) {
+        for (int i = 0; i < 2; i++) {
+            ramps[i].value = (s32)state.vol[i] << 16;
+            ramps[i].target = (s32)state.target[i] << 16;
+            rates[i] = state.rate[i];
+            sequence[i] = state.vol[i] * state.rate[i];
+        }
+    } else {
+        wet = hle_rdram_u32(address + ENVMIX_STATE_WET);
+        dry = hle_rdram_u32(address + ENVMIX_STATE_DRY);
+        for (int i = 0; i < 2; i++) {
+            ramps[i].target = (s32)hle_rdram_u32(address + ENVMIX_STATE_TARGET + i * 4);
+            rates[i] = hle_rdram_u32(address + ENVMIX_STATE_RATE + i * 4);
+            sequence[i] = hle_rdram_u32(address + ENVMIX_STATE_SEQUENCE + i * 4);
+            ramps[i].value = (s32)hle_rdram_u32(address + ENVMIX_STATE_VALUE + i * 4);
+        }
+    }
+
+    u16 dmem_in = state.in;
+    u16 outputs[4] = { state.out, state.dry_right, state.wet_left, state.wet_right };
+    int num_outputs = aux ? 4 : 2;
+
+    int ptr = 0;
+    for (int y = 0; y < state.count; y += 16) {
+        // Volume moves exponentially towards the target, linearly within each 8 samples
+        for (int i = 0; i < 2; i++) {
+            sequence[i] = ((s64)sequence[i] * rates[i]) >> 16;
+            ramps[i].step = (sequence[i] - ramps[i].value) >> 3;
+        }
+
+        for (int x = 0; x < 8; x++, ptr += 2) {
+            s16 left = ramp_step(&ramps[0]);
+            s16 right = ramp_step(&ramps[1]);
+            s16 gains[4] = {
+                hle_clamp_s16((left * dry + 0x4000) >> 15),
+                hle_clamp_s16((right * dry + 0x4000) >> 15),
+                hle_clamp_s16((left * wet + 0x4000) >> 15),
+                hle_clamp_s16((right * wet + 0x4000) >> 15)
+            };
+
+            s16 in = hle_dmem_s16(dmem_in + ptr);
+            for (int i = 0; i < num_outputs; i++) {
+                hle_dmem_write_s16(outputs[i] + ptr, mix_sample(hle_dmem_s16(outputs[i] + ptr), in, gains[i]));
+            }
+        }
+    }
+
+    hle_rdram_write_u32(address + ENVMIX_STATE_WET, wet);
+    hle_rdram_write_u32(address + ENVMIX_STATE_DRY, dry);
+    for (int i = 0; i < 2; i++) {
+        hle_rdram_write_u32(address + ENVMIX_STATE_TARGET + i * 4, ramps[i].target);
+        hle_rdram_write_u32(address + ENVMIX_STATE_RATE + i * 4, rates[i]);
+        hle_rdram_write_u32(address + ENVMIX_STATE_SEQUENCE + i * 4, sequence[i]);
+        hle_rdram_write_u32(address + ENVMIX_STATE_VALUE + i * 4, ramps[i].value);
+    }
+}
+
+static void polef(bool init, u16 dmemo, u16 dmemi, u16 count, u16 gain, u32 address) {
+    const s16* h1 = state.table;
+    s16 h2_before[8];
+    s16 h2[8];
+    for (int i = 0; i < 8; i++) {
+        h2_before[i] = state.table[8 + i];
+        h2[i] = ((s32)state.table[8 + i] * gain) >> 14;
+    }
+
+    s16 l1 = 0;
+    s16 l2 = 0;
+    if (!init) {
+        l1 = hle_rdram_s16(address + 4);
+        l2 = hle_rdram_s16(address + 6);
+    }
+
+    s16 frame[8];
+    s16 out[8];
+    for (count = ALIGN(count, 16); count != 0; count -= 16) {
+        for (int i = 0; i < 8; i++, dmemi += 2) {
+            frame[i] = hle_dmem_s16(dmemi);
+        }
+        for (int i = 0; i < 8; i++) {
+            s32 accumulator = frame[i] * gain;
+            accumulator += h1[i] * l1 + h2_before[i] * l2 + rdot(i, h2, frame);
+            out[i] = hle_clamp_s16(accumulator >> 14);
+        }
+        for (int i = 0; i < 8; i++, dmemo += 2) {
+            hle_dmem_write_s16(dmemo, out[i]);
+        }
+        l1 = out[6];
+        l2 = out[7];
+    }
+
+    for (int i = 0; i < 4; i++) {
+        hle_rdram_write_s16(address + i * 2, out[4 + i]);
+    }
+}
+
+void rsp_hle_audio_abi1_run(u32 ucode_data, u32 ucode_data_size, u32 data_ptr, u32 data_size) {
+    memset(state.segments, 0, sizeof(state.segments));
+    load_resample_lut(ucode_data, ucode_data_size);
+
+    for (u32 offset = 0; offset + 8 <= data_size; offset += 8) {
+        u32 w1 = hle_rdram_u32(data_ptr + offset);
+        u32 w2 = hle_rdram_u32(data_ptr + offset + 4);
+        u8 flags = w1 >> 16;
+
+        switch ((w1 >> 24) & 0x7F) {
+            case A_SPNOOP:
+                break;
+            case A_ADPCM:
+                adpcm(flags & A_INIT, flags & A_LOOP, state.out, state.in, ALIGN(state.count, 32), segmented_address(w2));
+                break;
+            case A_CLEARBUFF:
+                clear(DMEM_BASE + (u16)w1, ALIGN(w2 & 0xFFF, 16));
+                break;
+            case A_ENVMIXER:
+                envmixer(flags & A_INIT, flags & A_AUX, segmented_address(w2));
+                break;
+            case A_LOADBUFF:
+                load(state.in, segmented_address(w2), state.count);
+                break;
+            case A_RESAMPLE:
+                resample(flags & A_INIT, state.out, state.in, ALIGN(state.count, 16), (w1 & 0xFFFF) << 1, segmented_address(w2));
+                break;
+            case A_SAVEBUFF:
+                save(state.out, segmented_address(w2), state.count);
+                break;
+            case A_SEGMENT: {
+                u8 segment = (w2 >> 24) & 0x3F;
+                if (segment < NUM_SEGMENTS) {
+                    state.segments[segment] = w2 & 0xFFFFFF;
+                }
+                break;
+            }
+            case A_SETBUFF:
+                if (flags & A_AUX) {
+                    state.dry_right = DMEM_BASE + (u16)w1;
+                    state.wet_left = DMEM_BASE + (u16)(w2 >> 16);
+                    state.wet_right = DMEM_BASE + (u16)w2;
+                } else {
+                    state.in = DMEM_BASE + (u16)w1;
+                    state.out = DMEM_BASE + (u16)(w2 >> 16);
+                    state.count = w2;
+                }
+                break;
+            case A_SETVOL:
+                if (flags & A_AUX) {
+                    state.dry = w1;
+                    state.wet = w2;
+                } else {
+                    int side = (flags & A_LEFT) ? 0 : 1;
+                    if (flags & A_VOL) {
+                        state.vol[side] = w1;
+                    } else {
+                        state.target[side] = w1;
+                        state.rate[side] = w2;
+                    }
+                }
+                break;
+            case A_DMEMMOVE:
+                move(DMEM_BASE + (u16)(w2 >> 16), DMEM_BASE + (u16)w1, ALIGN(w2 & 0xFFFF, 16));
+                break;
+            case A_LOADADPCM: {
+                u32 address = segmented_address(w2);
+                int entries = ALIGN(w1 & 0xFFFF, 8) / 2;
+                if (entries > (int)(sizeof(state.table) / sizeof(s16))) {
+                    entries = sizeof(state.table) / sizeof(s16);
+                }
+                for (int i = 0; i < entries; i++) {
+                    state.table[i] = hle_rdram_s16(address + i * 2);
+                }
+                break;
+            }
+            case A_MIXER:
+                mix(DMEM_BASE + (u16)w2, DMEM_BASE + (u16)(w2 >> 16), ALIGN(state.count, 32), (s16)w1);
+                break;
+            case A_INTERLEAVE:
+                interleave(state.out, DMEM_BASE + (u16)(w2 >> 16), DMEM_BASE + (u16)w2, ALIGN(state.count, 16));
+                break;
+            case A_POLEF:
+                if (state.count != 0) {
+                    polef(flags & A_INIT, state.out, state.in, state.count, w1, segmented_address(w2));
+                }
+                break;
+            case A_SETLOOP:
+                state.loop = segmented_address(w2);
+                break;
+            default:
+                logwarn("Audio HLE: unknown command 0x%02X", (w1 >> 24) & 0x7F);
+                break;
+        }
+    }
+}
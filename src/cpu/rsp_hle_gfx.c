@@ -0,0 +1,1103 @@
+#include "rsp_hle.h"
+
+#include <string.h>
+#include <math.h>
+#include <log.h>
+#include <rdp/rdp.h>
+#ifdef N64_USE_SIMD
+#include <xmmintrin.h>
+#endif
+
+// Native implementation of the common libultra graphics microcode: Fast3D, F3DEX 1.x and F3DEX2 (and F3DZEX, which
+// takes the same commands). Display lists are walked on the host, vertices are transformed, lit and clipped, and the
+// resulting RDP commands go straight to the RDP without going through RDRAM or the DPC registers.
+//
+// This isn't a bit exact reimplementation: transforms are done in floating point and triangles are clipped and set up
+// the simple way, so edges and depth can be very slightly different to what the microcode would have produced.
+// Texture coordinate generation, line drawing and vertex modification aren't supported.
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+#define CLAMP(x, lo, hi) MIN(MAX(x, lo), hi)
+
+#define MAX_VERTICES 32
+#define MAX_LIGHTS 8
+#define MATRIX_STACK_SIZE 32
+#define DL_STACK_SIZE 18
+#define NUM_SEGMENTS 16
+// Stops a corrupted display list looping forever
+#define MAX_COMMANDS_PER_TASK 0x400000
+
+// Clipped polygons are at most the triangle plus one vertex per plane
+#define NUM_CLIP_PLANES 5
+#define MAX_CLIPPED_VERTICES (3 + NUM_CLIP_PLANES)
+
+#define CLIP_NEAR   (1 << 0)
+#define CLIP_LEFT   (1 << 1)
+#define CLIP_RIGHT  (1 << 2)
+#define CLIP_TOP    (1 << 3)
+#define CLIP_BOTTOM (1 << 4)
+
+// Moveword indices, the same in every family
+#define G_MW_MATRIX    0x00
+#define G_MW_NUMLIGHT  0x02
+#define G_MW_CLIP      0x04
+#define G_MW_SEGMENT   0x06
+#define G_MW_FOG       0x08
+#define G_MW_LIGHTCOL  0x0A
+#define G_MW_POINTS    0x0C
+#define G_MW_PERSPNORM 0x0E
+
+// Othermode H bit that turns on perspective correction in the RDP
+#define G_TP_PERSP (1 << 19)
+
+// Commands, independent of which microcode they came from
+typedef enum gfx_op {
+    OP_UNKNOWN,
+    OP_NOOP,
+    OP_MTX,
+    OP_POPMTX,
+    OP_MOVEMEM,
+    OP_MOVEWORD,
+    OP_VTX,
+    OP_DL,
+    OP_ENDDL,
+    OP_TRI1,
+    OP_TRI2,
+    OP_QUAD,
+    OP_TEXTURE,
+    OP_SETGEOMETRYMODE,
+    OP_CLEARGEOMETRYMODE,
+    OP_GEOMETRYMODE,
+    OP_SETOTHERMODE_H,
+    OP_SETOTHERMODE_L,
+    OP_RDPSETOTHERMODE,
+    OP_RDPHALF_1,
+    OP_RDPHALF_2,
+    OP_BRANCH_Z,
+    OP_CULLDL,
+    OP_LOAD_UCODE,
+    OP_TEXRECT,
+    OP_RDP,
+    OP_RDP_ADDRESS,
+    OP_UNSUPPORTED
+} gfx_op_t;
+
+// Geometry mode bits, which moved around between families
+typedef struct geometry_bits {
+    u32 zbuffer;
+    u32 shade;
+    u32 shading_smooth;
+    u32 cull_front;
+    u32 cull_back;
+    u32 fog;
+    u32 lighting;
+    u32 texture_gen;
+} geometry_bits_t;
+
+static const geometry_bits_t f3d_geometry = {
+        .zbuffer = 0x1, .shade = 0x4, .shading_smooth = 0x200, .cull_front = 0x1000, .cull_back = 0x2000,
+        .fog = 0x10000, .lighting = 0x20000, .texture_gen = 0x40000
+};
+
+static const geometry_bits_t f3dex2_geometry = {
+        .zbuffer = 0x1, .shade = 0x4, .shading_smooth = 0x200000, .cull_front = 0x200, .cull_back = 0x400,
+        .fog = 0x10000, .lighting = 0x20000, .texture_gen = 0x40000
+};
+
+typedef struct gfx_vertex {
+    float clip[4];
+    float screen[3]; // x and y in pixels, z in the RDP's depth units
+    float inv_w;
+    float colour[4]; // 0-255
+    float s;
+    float t;
+    u8 clip_flags;
+} gfx_vertex_t;
+
+typedef struct gfx_light {
+    float colour[3];
+    float direction[3];
+} gfx_light_t;
+
+static struct {
+    rsp_hle_gfx_ucode_t ucode;
+    const gfx_op_t* ops;
+    const geometry_bits_t* geometry_bits;
+
+    u32 segments[NUM_SEGMENTS];
+    u32 dl_stack[DL_STACK_SIZE];
+    int dl_depth;
+
+    float modelview[MATRIX_STACK_SIZE][4][4];
+    int modelview_depth;
+    float projection[4][4];
+    float mvp[4][4];
+    bool mvp_dirty;
+
+    float viewport_scale[3];
+    float viewport_translate[3];
+    float clip_ratio;
+
+    gfx_light_t lights[MAX_LIGHTS + 1]; // the light after the last directional one is the ambient light
+    int num_lights;
+
+    s16 fog_multiplier;
+    s16 fog_offset;
+
+    u32 geometry_mode;
+    u32 othermode_h;
+    u32 othermode_l;
+
+    bool texture_on;
+    int texture_tile;
+    int texture_level;
+    float texture_scale_s;
+    float texture_scale_t;
+
+    u32 rdphalf_1;
+
+    gfx_vertex_t vertices[MAX_VERTICES];
+} gfx;
+
+void (*rsp_hle_gfx_rdp_command)(int command_length, u32* buffer) = rdp_run_hle_command;
+
+static gfx_op_t f3d_ops[256];
+static gfx_op_t f3dex_ops[256];
+static gfx_op_t f3dex2_ops[256];
+static bool ops_built = false;
+
+static void build_rdp_ops(gfx_op_t* ops) {
+    for (int i = 0xE4; i <= 0xFF; i++) {
+        ops[i] = OP_RDP;
+    }
+    ops[0xE4] = OP_TEXRECT;
+    ops[0xE5] = OP_TEXRECT;
+    ops[0xEF] = OP_RDPSETOTHERMODE;
+    ops[0xF1] = OP_NOOP; // not an RDP command
+    ops[0xFD] = OP_RDP_ADDRESS;
+    ops[0xFE] = OP_RDP_ADDRESS;
+    ops[0xFF] = OP_RDP_ADDRESS;
+}
+
+static void build_ops() {
+    // F3D and F3DEX share almost everything
+    gfx_op_t* f3d_family[2] = { f3d_ops, f3dex_ops };
+    for (int i = 0; i < 2; i++) {
+        gfx_op_t* ops = f3d_family[i];
+        ops[0x00] = OP_NOOP;
+        ops[0x01] = OP_MTX;
+        ops[0x03] = OP_MOVEMEM;
+        ops[0x04] = OP_VTX;
+        ops[0x06] = OP_DL;
+        ops[0x09] = OP_UNSUPPORTED; // SPRITE2D
+        ops[0xB2] = OP_RDPHALF_2; // RDPHALF_CONT
+        ops[0xB3] = OP_RDPHALF_2;
+        ops[0xB4] = OP_RDPHALF_1;
+        ops[0xB6] = OP_CLEARGEOMETRYMODE;
+        ops[0xB7] = OP_SETGEOMETRYMODE;
+        ops[0xB8] = OP_ENDDL;
+        ops[0xB9] = OP_SETOTHERMODE_L;
+        ops[0xBA] = OP_SETOTHERMODE_H;
+        ops[0xBB] = OP_TEXTURE;
+        ops[0xBC] = OP_MOVEWORD;
+        ops[0xBD] = OP_POPMTX;
+        ops[0xBE] = OP_CULLDL;
+        ops[0xBF] = OP_TRI1;
+        ops[0xC0] = OP_NOOP;
+        build_rdp_ops(ops);
+    }
+    f3d_ops[0xB5] = OP_UNSUPPORTED; // LINE3D
+    f3dex_ops[0xAF] = OP_LOAD_UCODE;
+    f3dex_ops[0xB0] = OP_BRANCH_Z;
+    f3dex_ops[0xB1] = OP_TRI2;
+    f3dex_ops[0xB5] = OP_QUAD;
+
+    f3dex2_ops[0x00] = OP_NOOP;
+    f3dex2_ops[0x01] = OP_VTX;
+    f3dex2_ops[0x02] = OP_UNSUPPORTED; // MODIFYVTX
+    f3dex2_ops[0x03] = OP_CULLDL;
+    f3dex2_ops[0x04] = OP_BRANCH_Z;
+    f3dex2_ops[0x05] = OP_TRI1;
+    f3dex2_ops[0x06] = OP_TRI2;
+    f3dex2_ops[0x07] = OP_QUAD;
+    f3dex2_ops[0x08] = OP_UNSUPPORTED; // LINE3D
+    f3dex2_ops[0xC0] = OP_NOOP;
+    f3dex2_ops[0xD3] = OP_NOOP; // SPECIAL_3
+    f3dex2_ops[0xD4] = OP_NOOP; // SPECIAL_2
+    f3dex2_ops[0xD5] = OP_NOOP; // SPECIAL_1
+    f3dex2_ops[0xD6] = OP_UNSUPPORTED; // DMA_IO
+    f3dex2_ops[0xD7] = OP_TEXTURE;
+    f3dex2_ops[0xD8] = OP_POPMTX;
+    f3dex2_ops[0xD9] = OP_GEOMETRYMODE;
+    f3dex2_ops[0xDA] = OP_MTX;
+    f3dex2_ops[0xDB] = OP_MOVEWORD;
+    f3dex2_ops[0xDC] = OP_MOVEMEM;
+    f3dex2_ops[0xDD] = OP_LOAD_UCODE;
+    f3dex2_ops[0xDE] = OP_DL;
+    f3dex2_ops[0xDF] = OP_ENDDL;
+    f3dex2_ops[0xE0] = OP_NOOP;
+    build_rdp_ops(f3dex2_ops);
+    f3dex2_ops[0xE1] = OP_RDPHALF_1;
+    f3dex2_ops[0xE2] = OP_SETOTHERMODE_L;
+    f3dex2_ops[0xE3] = OP_SETOTHERMODE_H;
+    f3dex2_ops[0xF1] = OP_RDPHALF_2;
+
+    ops_built = true;
+}
+
+// The version string every libultra graphics microcode carries in its data segment
+static const char* find_string(u32 ucode_data, u32 size, const char* needle) {
+    static char data[0x1000];
+    size = MIN(size, sizeof(data) - 1);
+    for (u32 i = 0; i < size; i++) {
+        data[i] = hle_rdram_u8(ucode_data + i);
+        // Makes strstr see past any zeroes in the data
+        if (data[i] == '\0') {
+            data[i] = '\1';
+        }
+    }
+    data[size] = '\0';
+    return strstr(data, needle);
+}
+
+rsp_hle_gfx_ucode_t rsp_hle_gfx_identify(u32 ucode_data, u32 ucode_data_size) {
+    const char* version = find_string(ucode_data, ucode_data_size, "RSP Gfx ucode ");
+    if (version != NULL) {
+        // e.g. "RSP Gfx ucode F3DEX       fifo 2.08  Yoshitaka Yasumoto 1999 Nintendo."
+        const char* name = version + strlen("RSP Gfx ucode ");
+        bool f3dex = strncmp(name, "F3DEX ", 6) == 0 || strncmp(name, "F3DLX ", 6) == 0;
+        bool f3dzex = strncmp(name, "F3DZEX ", 7) == 0;
+        // Variants like F3DEX.NoN and F3DLX.Rej have different limits, so only the plain ones are taken
+        if (f3dex || f3dzex) {
+            const char* number = strstr(name, " 1.");
+            if (number == NULL) {
+                number = strstr(name, " 2.");
+            }
+            if (number != NULL && number - name < 32) {
+                return number[1] == '2' ? GFX_UCODE_F3DEX2 : GFX_UCODE_F3DEX;
+            }
+        }
+        return GFX_UCODE_UNKNOWN;
+    }
+
+    // Fast3D predates the version string format
+    if (find_string(ucode_data, ucode_data_size, "RSP SW Version: 2.0") != NULL) {
+        return GFX_UCODE_F3D;
+    }
+    return GFX_UCODE_UNKNOWN;
+}
+
+INLINE u32 segmented_address(u32 address) {
+    return (gfx.segments[(address >> 24) & 0xF] + (address & 0xFFFFFF)) & (N64_RDRAM_SIZE - 1);
+}
+
+static void warn_unsupported(u8 opcode) {
+    static bool warned[256];
+    if (!warned[opcode]) {
+        logwarn("Graphics HLE: command 0x%02X isn't supported, skipping it", opcode);
+        warned[opcode] = true;
+    }
+}
+
+// Matrices are row vectors times the matrix, the same as libultra
+
+INLINE void matrix_transform(const float m[4][4], float x, float y, float z, float* out) {
+#ifdef N64_USE_SIMD
+    __m128 result = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(m[0])), _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(m[1]))),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(m[2])), _mm_loadu_ps(m[3])));
+    _mm_storeu_ps(out, result);
+#else
+    for (int i = 0; i < 4; i++) {
+        out[i] = x * m[0][i] + y * m[1][i] + z * m[2][i] + m[3][i];
+    }
+#endif
+}
+
+static void matrix_multiply(float dst[4][4], const float a[4][4], const float b[4][4]) {
+    float result[4][4];
+    for (int i = 0; i < 4; i++) {
+#ifdef N64_USE_SIMD
+        __m128 row = _mm_mul_ps(_mm_set1_ps(a[i][0]), _mm_loadu_ps(b[0]));
+        for (int j = 1; j < 4; j++) {
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][j]), _mm_loadu_ps(b[j])));
+        }
+        _mm_storeu_ps(result[i], row);
+#else
+        for (int j = 0; j < 4; j++) {
+            result[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
+        }
+#endif
+    }
+    memcpy(dst, result, sizeof(result));
+}
+
+static void matrix_identity(float m[4][4]) {
+    memset(m, 0, sizeof(float) * 16);
+    for (int i = 0; i < 4; i++) {
+        m[i][i] = 1.0f;
+    }
+}
+
+// s15.16, all the integer halves and then all the fractions
+static void load_matrix(float m[4][4], u32 address) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            int index = i * 4 + j;
+            s16 integer = hle_rdram_s16(address + index * 2);
+            u16 fraction = hle_rdram_s16(address + 32 + index * 2);
+            m[i][j] = (float)(((s32)integer << 16) | fraction) / 65536.0f;
+        }
+    }
+}
+
+static void update_mvp() {
+    if (gfx.mvp_dirty) {
+        matrix_multiply(gfx.mvp, gfx.modelview[gfx.modelview_depth], gfx.projection);
+        gfx.mvp_dirty = false;
+    }
+}
+
+static void gfx_matrix(u32 w0, u32 w1) {
+    bool projection;
+    bool load;
+    bool push;
+    if (gfx.ucode == GFX_UCODE_F3DEX2) {
+        u8 params = (w0 & 0xFF) ^ 1;
+        push = params & 1;
+        load = params & 2;
+        projection = params & 4;
+    } else {
+        u8 params = w0 >> 16;
+        projection = params & 1;
+        load = params & 2;
+        push = params & 4;
+    }
+
+    float m[4][4];
+    load_matrix(m, segmented_address(w1));
+
+    if (projection) {
+        if (load) {
+            memcpy(gfx.projection, m, sizeof(m));
+        } else {
+            matrix_multiply(gfx.projection, m, gfx.projection);
+        }
+    } else {
+        if (push && gfx.modelview_depth < MATRIX_STACK_SIZE - 1) {
+            memcpy(gfx.modelview[gfx.modelview_depth + 1], gfx.modelview[gfx.modelview_depth], sizeof(m));
+            gfx.modelview_depth++;
+        }
+        float (*top)[4] = gfx.modelview[gfx.modelview_depth];
+        if (load) {
+            memcpy(top, m, sizeof(m));
+        } else {
+            matrix_multiply(top, m, top);
+        }
+    }
+    gfx.mvp_dirty = true;
+}
+
+static void gfx_pop_matrix(u32 w1) {
+    int count = gfx.ucode == GFX_UCODE_F3DEX2 ? w1 / 64 : 1;
+    gfx.modelview_depth = MAX(gfx.modelview_depth - count, 0);
+    gfx.mvp_dirty = true;
+}
+
+static void load_light(int index, u32 address) {
+    if (index < 0 || index > MAX_LIGHTS) {
+        return;
+    }
+    gfx_light_t* light = &gfx.lights[index];
+    float length = 0;
+    for (int i = 0; i < 3; i++) {
+        light->colour[i] = hle_rdram_u8(address + i);
+        light->direction[i] = (s8)hle_rdram_u8(address + 8 + i);
+        length += light->direction[i] * light->direction[i];
+    }
+    if (length > 0) {
+        length = sqrtf(length);
+        for (int i = 0; i < 3; i++) {
+            light->direction[i] /= length;
+        }
+    }
+}
+
+static void load_viewport(u32 address) {
+    // x and y are in quarter pixels
+    for (int i = 0; i < 3; i++) {
+        float divisor = i < 2 ? 4.0f : 1.0f;
+        gfx.viewport_scale[i] = hle_rdram_s16(address + i * 2) / divisor;
+        gfx.viewport_translate[i] = hle_rdram_s16(address + 8 + i * 2) / divisor;
+    }
+}
+
+static void gfx_movemem(u32 w0, u32 w1) {
+    u32 address = segmented_address(w1);
+    if (gfx.ucode == GFX_UCODE_F3DEX2) {
+        u8 index = w0;
+        u32 offset = ((w0 >> 8) & 0xFF) * 8;
+        switch (index) {
+            case 8:
+                load_viewport(address);
+                break;
+            case 10:
+                // The first two are the lookat vectors for texture coordinate generation
+                if (offset >= 48) {
+                    load_light(offset / 24 - 2, address);
+                }
+                break;
+        }
+    } else {
+        u8 index = w0 >> 16;
+        if (index == 0x80) {
+            load_viewport(address);
+        } else if (index >= 0x86 && index <= 0x94) {
+            load_light((index - 0x86) / 2, address);
+        }
+    }
+}
+
+static void gfx_moveword(u32 w0, u32 w1) {
+    u8 index;
+    u16 offset;
+    if (gfx.ucode == GFX_UCODE_F3DEX2) {
+        index = w0 >> 16;
+        offset = w0;
+    } else {
+        index = w0;
+        offset = w0 >> 8;
+    }
+
+    switch (index) {
+        case G_MW_NUMLIGHT:
+            gfx.num_lights = gfx.ucode == GFX_UCODE_F3DEX2 ? (int)(w1 / 24) : (int)((w1 - 0x80000000) >> 5) - 1;
+            gfx.num_lights = CLAMP(gfx.num_lights, 0, MAX_LIGHTS);
+            break;
+        case G_MW_CLIP:
+            // Each plane can be set separately, but in practice they always get the same ratio
+            if ((w1 & 0xFFFF) != 0) {
+                gfx.clip_ratio = w1 & 0xFFFF;
+            }
+            break;
+        case G_MW_SEGMENT:
+            gfx.segments[(offset / 4) & 0xF] = w1 & 0xFFFFFF;
+            break;
+        case G_MW_FOG:
+            gfx.fog_multiplier = w1 >> 16;
+            gfx.fog_offset = w1;
+            break;
+        case G_MW_LIGHTCOL: {
+            int stride = gfx.ucode == GFX_UCODE_F3DEX2 ? 24 : 32;
+            int light = offset / stride;
+            if (offset % stride == 0 && light <= MAX_LIGHTS) {
+                gfx.lights[light].colour[0] = w1 >> 24;
+                gfx.lights[light].colour[1] = (w1 >> 16) & 0xFF;
+                gfx.lights[light].colour[2] = (w1 >> 8) & 0xFF;
+            }
+            break;
+        }
+        case G_MW_MATRIX:
+        case G_MW_POINTS:
+            warn_unsupported(w0 >> 24);
+            break;
+        case G_MW_PERSPNORM:
+            // Only used to keep the microcode's fixed point in range
+            break;
+    }
+}
+
+INLINE u8 compute_clip_flags(const float* clip) {
+    float limit = clip[3] * gfx.clip_ratio;
+    u8 flags = 0;
+    if (clip[2] < -clip[3]) flags |= CLIP_NEAR;
+    if (clip[0] < -limit)   flags |= CLIP_LEFT;
+    if (clip[0] > limit)    flags |= CLIP_RIGHT;
+    if (clip[1] > limit)    flags |= CLIP_TOP;
+    if (clip[1] < -limit)   flags |= CLIP_BOTTOM;
+    return flags;
+}
+
+static void project(gfx_vertex_t* v) {
+    float w = v->clip[3];
+    v->inv_w = w > 0 ? 1.0f / w : 1.0f;
+    v->screen[0] = v->clip[0] * v->inv_w * gfx.viewport_scale[0] + gfx.viewport_translate[0];
+    v->screen[1] = -v->clip[1] * v->inv_w * gfx.viewport_scale[1] + gfx.viewport_translate[1];
+    // The RDP wants depth in 15 bits, the viewport gives it in 10
+    float z = (v->clip[2] * v->inv_w * gfx.viewport_scale[2] + gfx.viewport_translate[2]) * 32.0f;
+    v->screen[2] = CLAMP(z, 0.0f, 32767.0f);
+}
+
+static void light_vertex(gfx_vertex_t* v, s8 nx, s8 ny, s8 nz) {
+    const float (*mv)[4] = (const float (*)[4])gfx.modelview[gfx.modelview_depth];
+    float normal[3];
+    float length = 0;
+    for (int i = 0; i < 3; i++) {
+        normal[i] = nx * mv[0][i] + ny * mv[1][i] + nz * mv[2][i];
+        length += normal[i] * normal[i];
+    }
+    length = length > 0 ? 1.0f / sqrtf(length) : 0;
+
+    float colour[3];
+    const gfx_light_t* ambient = &gfx.lights[gfx.num_lights];
+    for (int i = 0; i < 3; i++) {
+        colour[i] = ambient->colour[i];
+    }
+    for (int l = 0; l < gfx.num_lights; l++) {
+        const gfx_light_t* light = &gfx.lights[l];
+        float intensity = (normal[0] * light->direction[0] + normal[1] * light->direction[1] + normal[2] * light->direction[2]) * length;
+        if (intensity > 0) {
+            for (int i = 0; i < 3; i++) {
+                colour[i] += light->colour[i] * intensity;
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        v->colour[i] = MIN(colour[i], 255.0f);
+    }
+}
+
+static void gfx_vertices(u32 w0, u32 w1) {
+    int count;
+    int first;
+    switch (gfx.ucode) {
+        case GFX_UCODE_F3D:
+            count = ((w0 >> 20) & 0xF) + 1;
+            first = (w0 >> 16) & 0xF;
+            break;
+        case GFX_UCODE_F3DEX:
+            count = (w0 >> 10) & 0x3F;
+            first = ((w0 >> 16) & 0xFF) / 2;
+            break;
+        default:
+            count = (w0 >> 12) & 0xFF;
+            first = ((w0 >> 1) & 0x7F) - count;
+            break;
+    }
+    if (first < 0 || first + count > MAX_VERTICES) {
+        logwarn("Graphics HLE: loading %d vertices at %d overflows the vertex buffer", count, first);
+        return;
+    }
+
+    update_mvp();
+    const geometry_bits_t* bits = gfx.geometry_bits;
+    if ((gfx.geometry_mode & bits->texture_gen) && gfx.texture_on) {
+        warn_unsupported(w0 >> 24);
+    }
+
+    u32 address = segmented_address(w1);
+    for (int i = 0; i < count; i++, address += 16) {
+        gfx_vertex_t* v = &gfx.vertices[first + i];
+        float x = hle_rdram_s16(address);
+        float y = hle_rdram_s16(address + 2);
+        float z = hle_rdram_s16(address + 4);
+        matrix_transform(gfx.mvp, x, y, z, v->clip);
+        v->clip_flags = compute_clip_flags(v->clip);
+        project(v);
+
+        v->s = hle_rdram_s16(address + 8) * gfx.texture_scale_s;
+        v->t = hle_rdram_s16(address + 10) * gfx.texture_scale_t;
+
+        u8 rgba[4];
+        for (int c = 0; c < 4; c++) {
+            rgba[c] = hle_rdram_u8(address + 12 + c);
+            v->colour[c] = rgba[c];
+        }
+        if (gfx.geometry_mode & bits->lighting) {
+            light_vertex(v, (s8)rgba[0], (s8)rgba[1], (s8)rgba[2]);
+        }
+        if (gfx.geometry_mode & bits->fog) {
+            float fog = v->clip[2] * v->inv_w * gfx.fog_multiplier + gfx.fog_offset;
+            v->colour[3] = CLAMP(fog, 0.0f, 255.0f);
+        }
+    }
+}
+
+INLINE s32 to_s16_16(double value) {
+    value *= 65536.0;
+    if (value >= 2147483647.0) return 0x7FFFFFFF;
+    if (value <= -2147483648.0) return (s32)0x80000000;
+    return (s32)value;
+}
+
+typedef struct triangle_setup {
+    double hx, hy;
+    double mx, my;
+    double fy;
+    double ish;
+    double attr_factor;
+} triangle_setup_t;
+
+// Works out an attribute's gradients from its value at each vertex
+static void attribute_coefficients(const triangle_setup_t* setup, const double* v1, const double* v2, const double* v3,
+                                   s32* value, s32* dx, s32* de, s32* dy, int count) {
+    for (int i = 0; i < count; i++) {
+        double mc = v2[i] - v1[i];
+        double hc = v3[i] - v1[i];
+        double dcdx = (setup->hy * mc - setup->my * hc) * setup->attr_factor;
+        double dcdy = (setup->mx * hc - setup->hx * mc) * setup->attr_factor;
+        double dcde = dcdy + dcdx * setup->ish;
+        value[i] = to_s16_16(v1[i] + setup->fy * dcde);
+        dx[i] = to_s16_16(dcdx);
+        de[i] = to_s16_16(dcde);
+        dy[i] = to_s16_16(dcdy);
+    }
+}
+
+// Shade and texture coefficients share a layout: the integer parts of four attributes, then their fractions, for the
+// value, then d/dx, d/de and d/dy
+static u32* write_attribute_block(u32* out, const s32* value, const s32* dx, const s32* de, const s32* dy) {
+    const s32* parts[4] = { value, dx, de, dy };
+    for (int p = 0; p < 4; p++) {
+        // Value and d/dx, then d/de and d/dy, are interleaved
+        u32* block = out + (p / 2) * 8 + (p % 2) * 2;
+        const s32* v = parts[p];
+        block[0] = (v[0] & 0xFFFF0000) | ((u32)v[1] >> 16);
+        block[1] = (v[2] & 0xFFFF0000) | ((u32)v[3] >> 16);
+        block[4] = ((u32)v[0] << 16) | (v[1] & 0xFFFF);
+        block[5] = ((u32)v[2] << 16) | (v[3] & 0xFFFF);
+    }
+    return out + 16;
+}
+
+static void draw_triangle(const gfx_vertex_t* a, const gfx_vertex_t* b, const gfx_vertex_t* c, const float* flat_colour) {
+    const geometry_bits_t* bits = gfx.geometry_bits;
+    bool shade = gfx.geometry_mode & bits->shade;
+    bool texture = gfx.texture_on;
+    bool zbuffer = gfx.geometry_mode & bits->zbuffer;
+
+    // Top to bottom
+    const gfx_vertex_t* v[3] = { a, b, c };
+    if (v[1]->screen[1] < v[0]->screen[1]) { const gfx_vertex_t* tmp = v[0]; v[0] = v[1]; v[1] = tmp; }
+    if (v[2]->screen[1] < v[1]->screen[1]) { const gfx_vertex_t* tmp = v[1]; v[1] = v[2]; v[2] = tmp; }
+    if (v[1]->screen[1] < v[0]->screen[1]) { const gfx_vertex_t* tmp = v[0]; v[0] = v[1]; v[1] = tmp; }
+
+    double x1 = v[0]->screen[0], x2 = v[1]->screen[0], x3 = v[2]->screen[0];
+    // y is s11.2
+    s32 y1f = CLAMP((s32)floor(v[0]->screen[1] * 4), -4096 * 4, 4095 * 4);
+    s32 y2f = CLAMP((s32)floor(v[1]->screen[1] * 4), -4096 * 4, 4095 * 4);
+    s32 y3f = CLAMP((s32)floor(v[2]->screen[1] * 4), -4096 * 4, 4095 * 4);
+    double y1 = y1f / 4.0, y2 = y2f / 4.0, y3 = y3f / 4.0;
+
+    triangle_setup_t setup;
+    setup.hx = x3 - x1;
+    setup.hy = y3 - y1;
+    setup.mx = x2 - x1;
+    setup.my = y2 - y1;
+    double lx = x3 - x2;
+    double ly = y3 - y2;
+    double nz = setup.hx * setup.my - setup.hy * setup.mx;
+    setup.attr_factor = fabs(nz) > 1e-12 ? -1.0 / nz : 0;
+    bool lft = nz < 0;
+
+    setup.ish = fabs(setup.hy) > 1e-12 ? setup.hx / setup.hy : 0;
+    double ism = fabs(setup.my) > 1e-12 ? setup.mx / setup.my : 0;
+    double isl = fabs(ly) > 1e-12 ? lx / ly : 0;
+    setup.fy = floor(y1) - y1;
+
+    int command = 0x08 | (shade << 2) | (texture << 1) | zbuffer;
+
+    u64 storage[22];
+    u32* words = (u32*)storage;
+    words[0] = (command << 24) | (lft << 23) | ((gfx.texture_level & 7) << 19) | ((gfx.texture_tile & 7) << 16) | (y3f & 0x3FFF);
+    words[1] = ((y2f & 0x3FFF) << 16) | (y1f & 0x3FFF);
+    words[2] = to_s16_16(x2);
+    words[3] = to_s16_16(isl);
+    words[4] = to_s16_16(x1 + setup.fy * setup.ish);
+    words[5] = to_s16_16(setup.ish);
+    words[6] = to_s16_16(x1 + setup.fy * ism);
+    words[7] = to_s16_16(ism);
+    u32* out = &words[8];
+
+    s32 value[4], dx[4], de[4], dy[4];
+    if (shade) {
+        double colours[3][4];
+        for (int i = 0; i < 3; i++) {
+            for (int c = 0; c < 4; c++) {
+                colours[i][c] = flat_colour != NULL ? flat_colour[c] : v[i]->colour[c];
+            }
+        }
+        attribute_coefficients(&setup, colours[0], colours[1], colours[2], value, dx, de, dy, 4);
+        out = write_attribute_block(out, value, dx, de, dy);
+    }
+
+    if (texture) {
+        double coords[3][4];
+        bool perspective = gfx.othermode_h & G_TP_PERSP;
+        double max_inv_w = MAX(MAX(v[0]->inv_w, v[1]->inv_w), v[2]->inv_w);
+        for (int i = 0; i < 3; i++) {
+            double w = perspective && max_inv_w > 0 ? v[i]->inv_w / max_inv_w : 1.0;
+            coords[i][0] = v[i]->s * w;
+            coords[i][1] = v[i]->t * w;
+            coords[i][2] = w * 0x7FFF;
+            coords[i][3] = 0;
+        }
+        attribute_coefficients(&setup, coords[0], coords[1], coords[2], value, dx, de, dy, 4);
+        out = write_attribute_block(out, value, dx, de, dy);
+    }
+
+    if (zbuffer) {
+        double z[3][1] = { { v[0]->screen[2] }, { v[1]->screen[2] }, { v[2]->screen[2] } };
+        attribute_coefficients(&setup, z[0], z[1], z[2], value, dx, de, dy, 1);
+        out[0] = value[0];
+        out[1] = dx[0];
+        out[2] = de[0];
+        out[3] = dy[0];
+        out += 4;
+    }
+
+    rsp_hle_gfx_rdp_command(out - words, words);
+}
+
+static void interpolate_vertex(gfx_vertex_t* out, const gfx_vertex_t* a, const gfx_vertex_t* b, float t) {
+    for (int i = 0; i < 4; i++) {
+        out->clip[i] = a->clip[i] + (b->clip[i] - a->clip[i]) * t;
+        out->colour[i] = a->colour[i] + (b->colour[i] - a->colour[i]) * t;
+    }
+    out->s = a->s + (b->s - a->s) * t;
+    out->t = a->t + (b->t - a->t) * t;
+    project(out);
+}
+
+// Distance inside each plane, the polygon's kept where it's positive
+INLINE float plane_distance(const gfx_vertex_t* v, int plane) {
+    float limit = v->clip[3] * gfx.clip_ratio;
+    switch (plane) {
+        case 0: return v->clip[2] + v->clip[3];
+        case 1: return v->clip[0] + limit;
+        case 2: return limit - v->clip[0];
+        case 3: return limit - v->clip[1];
+        default: return v->clip[1] + limit;
+    }
+}
+
+// Sutherland-Hodgman against whichever planes the triangle crosses
+static int clip_polygon(gfx_vertex_t* polygon, int count, u8 planes) {
+    gfx_vertex_t scratch[MAX_CLIPPED_VERTICES];
+    gfx_vertex_t* in = polygon;
+    gfx_vertex_t* out = scratch;
+
+    for (int plane = 0; plane < NUM_CLIP_PLANES && count >= 3; plane++) {
+        if (!(planes & (1 << plane))) {
+            continue;
+        }
+        int out_count = 0;
+        for (int i = 0; i < count; i++) {
+            const gfx_vertex_t* current = &in[i];
+            const gfx_vertex_t* next = &in[(i + 1) % count];
+            float d_current = plane_distance(current, plane);
+            float d_next = plane_distance(next, plane);
+            if (d_current >= 0) {
+                out[out_count++] = *current;
+            }
+            if ((d_current >= 0) != (d_next >= 0)) {
+                interpolate_vertex(&out[out_count++], current, next, d_current / (d_current - d_next));
+            }
+        }
+        count = out_count;
+        gfx_vertex_t* tmp = in;
+        in = out;
+        out = tmp;
+    }
+
+    if (in != polygon) {
+        memcpy(polygon, in, sizeof(gfx_vertex_t) * count);
+    }
+    return count;
+}
+
+INLINE float polygon_area(const gfx_vertex_t* polygon, int count) {
+    float area = 0;
+    for (int i = 0; i < count; i++) {
+        const gfx_vertex_t* a = &polygon[i];
+        const gfx_vertex_t* b = &polygon[(i + 1) % count];
+        area += a->screen[0] * b->screen[1] - b->screen[0] * a->screen[1];
+    }
+    return area;
+}
+
+static void gfx_triangle(int i1, int i2, int i3, int flat_index) {
+    if (i1 >= MAX_VERTICES || i2 >= MAX_VERTICES || i3 >= MAX_VERTICES) {
+        return;
+    }
+    const gfx_vertex_t* v1 = &gfx.vertices[i1];
+    const gfx_vertex_t* v2 = &gfx.vertices[i2];
+    const gfx_vertex_t* v3 = &gfx.vertices[i3];
+
+    // All outside the same plane
+    if (v1->clip_flags & v2->clip_flags & v3->clip_flags) {
+        return;
+    }
+
+    gfx_vertex_t polygon[MAX_CLIPPED_VERTICES] = { *v1, *v2, *v3 };
+    int count = 3;
+    u8 crossed = v1->clip_flags | v2->clip_flags | v3->clip_flags;
+    if (crossed) {
+        count = clip_polygon(polygon, count, crossed);
+        if (count < 3) {
+            return;
+        }
+    }
+
+    // Screen y points down, so front faces, anticlockwise in clip space, come out with negative area
+    const geometry_bits_t* bits = gfx.geometry_bits;
+    float area = polygon_area(polygon, count);
+    if (area == 0) {
+        return;
+    }
+    if ((gfx.geometry_mode & bits->cull_back) && area > 0) {
+        return;
+    }
+    if ((gfx.geometry_mode & bits->cull_front) && area < 0) {
+        return;
+    }
+
+    const float* flat_colour = NULL;
+    if (!(gfx.geometry_mode & bits->shading_smooth)) {
+        flat_colour = gfx.vertices[flat_index < MAX_VERTICES ? flat_index : i1].colour;
+    }
+
+    for (int i = 1; i + 1 < count; i++) {
+        draw_triangle(&polygon[0], &polygon[i], &polygon[i + 1], flat_colour);
+    }
+}
+
+static void gfx_tri1(u32 w0, u32 w1) {
+    switch (gfx.ucode) {
+        case GFX_UCODE_F3D: {
+            int i1 = ((w1 >> 16) & 0xFF) / 10;
+            int i2 = ((w1 >> 8) & 0xFF) / 10;
+            int i3 = (w1 & 0xFF) / 10;
+            int flag = w1 >> 24;
+            int indices[3] = { i1, i2, i3 };
+            gfx_triangle(i1, i2, i3, indices[flag < 3 ? flag : 0]);
+            break;
+        }
+        case GFX_UCODE_F3DEX: {
+            int i1 = ((w1 >> 16) & 0xFF) / 2;
+            gfx_triangle(i1, ((w1 >> 8) & 0xFF) / 2, (w1 & 0xFF) / 2, i1);
+            break;
+        }
+        default: {
+            int i1 = ((w0 >> 16) & 0xFF) / 2;
+            gfx_triangle(i1, ((w0 >> 8) & 0xFF) / 2, (w0 & 0xFF) / 2, i1);
+            break;
+        }
+    }
+}
+
+static void gfx_tri2(u32 w0, u32 w1) {
+    int a = ((w0 >> 16) & 0xFF) / 2;
+    gfx_triangle(a, ((w0 >> 8) & 0xFF) / 2, (w0 & 0xFF) / 2, a);
+    int b = ((w1 >> 16) & 0xFF) / 2;
+    gfx_triangle(b, ((w1 >> 8) & 0xFF) / 2, (w1 & 0xFF) / 2, b);
+}
+
+static void gfx_quad(u32 w0, u32 w1) {
+    if (gfx.ucode == GFX_UCODE_F3DEX2) {
+        gfx_tri2(w0, w1);
+        return;
+    }
+    int v0 = (w1 >> 24) / 2;
+    int v1 = ((w1 >> 16) & 0xFF) / 2;
+    int v2 = ((w1 >> 8) & 0xFF) / 2;
+    int v3 = (w1 & 0xFF) / 2;
+    gfx_triangle(v0, v1, v2, v0);
+    gfx_triangle(v0, v2, v3, v0);
+}
+
+static void gfx_texture(u32 w0, u32 w1) {
+    gfx.texture_level = (w0 >> 11) & 7;
+    gfx.texture_tile = (w0 >> 8) & 7;
+    gfx.texture_on = gfx.ucode == GFX_UCODE_F3DEX2 ? (w0 >> 1) & 0x7F : w0 & 0xFF;
+    // 0x10000 would be 1.0, but doesn't fit, so 0xFFFF stands in for it
+    u16 scale_s = w1 >> 16;
+    u16 scale_t = w1;
+    gfx.texture_scale_s = scale_s == 0xFFFF ? 1.0f : scale_s / 65536.0f;
+    gfx.texture_scale_t = scale_t == 0xFFFF ? 1.0f : scale_t / 65536.0f;
+}
+
+static void send_othermode() {
+    u32 command[2] = { 0xEF000000 | (gfx.othermode_h & 0xFFFFFF), gfx.othermode_l };
+    rsp_hle_gfx_rdp_command(2, command);
+}
+
+static void gfx_set_othermode(u32* mode, u32 w0, u32 w1) {
+    int length;
+    int shift;
+    if (gfx.ucode == GFX_UCODE_F3DEX2) {
+        length = (w0 & 0xFF) + 1;
+        shift = 32 - ((w0 >> 8) & 0xFF) - length;
+    } else {
+        shift = (w0 >> 8) & 0xFF;
+        length = w0 & 0xFF;
+    }
+    if (shift < 0 || length <= 0 || shift + length > 32) {
+        return;
+    }
+    u32 mask = (length == 32 ? 0xFFFFFFFF : ((1u << length) - 1)) << shift;
+    *mode = (*mode & ~mask) | (w1 & mask);
+    send_othermode();
+}
+
+static void reset_state(rsp_hle_gfx_ucode_t ucode) {
+    memset(&gfx, 0, sizeof(gfx));
+    gfx.ucode = ucode;
+    switch (ucode) {
+        case GFX_UCODE_F3D:
+            gfx.ops = f3d_ops;
+            gfx.geometry_bits = &f3d_geometry;
+            break;
+        case GFX_UCODE_F3DEX:
+            gfx.ops = f3dex_ops;
+            gfx.geometry_bits = &f3d_geometry;
+            break;
+        default:
+            gfx.ops = f3dex2_ops;
+            gfx.geometry_bits = &f3dex2_geometry;
+            break;
+    }
+    matrix_identity(gfx.modelview[0]);
+    matrix_identity(gfx.projection);
+    gfx.mvp_dirty = true;
+    gfx.clip_ratio = 2.0f;
+    gfx.texture_scale_s = 1.0f;
+    gfx.texture_scale_t = 1.0f;
+    // 320x240, until the display list sets its own
+    gfx.viewport_scale[0] = gfx.viewport_translate[0] = 160.0f;
+    gfx.viewport_scale[1] = gfx.viewport_translate[1] = 120.0f;
+    gfx.viewport_scale[2] = gfx.viewport_translate[2] = 511.0f;
+}
+
+void rsp_hle_gfx_vertex_screen(int index, float* screen) {
+    memcpy(screen, gfx.vertices[index].screen, sizeof(gfx.vertices[index].screen));
+}
+
+void rsp_hle_gfx_run(rsp_hle_gfx_ucode_t ucode, u32 data_ptr) {
+    if (unlikely(!ops_built)) {
+        build_ops();
+    }
+    reset_state(ucode);
+
+    u32 pc = data_ptr & (N64_RDRAM_SIZE - 1);
+    for (int executed = 0; executed < MAX_COMMANDS_PER_TASK; executed++) {
+        u32 w0 = hle_rdram_u32(pc);
+        u32 w1 = hle_rdram_u32(pc + 4);
+        u8 opcode = w0 >> 24;
+        pc += 8;
+
+        switch (gfx.ops[opcode]) {
+            case OP_NOOP:
+            case OP_CULLDL: // Only saves time, drawing everything anyway gives the same picture
+                break;
+            case OP_MTX:
+                gfx_matrix(w0, w1);
+                break;
+            case OP_POPMTX:
+                gfx_pop_matrix(w1);
+                break;
+            case OP_MOVEMEM:
+                gfx_movemem(w0, w1);
+                break;
+            case OP_MOVEWORD:
+                gfx_moveword(w0, w1);
+                break;
+            case OP_VTX:
+                gfx_vertices(w0, w1);
+                break;
+            case OP_TRI1:
+                gfx_tri1(w0, w1);
+                break;
+            case OP_TRI2:
+                gfx_tri2(w0, w1);
+                break;
+            case OP_QUAD:
+                gfx_quad(w0, w1);
+                break;
+            case OP_TEXTURE:
+                gfx_texture(w0, w1);
+                break;
+            case OP_SETGEOMETRYMODE:
+                gfx.geometry_mode |= w1;
+                break;
+            case OP_CLEARGEOMETRYMODE:
+                gfx.geometry_mode &= ~w1;
+                break;
+            case OP_GEOMETRYMODE:
+                gfx.geometry_mode = (gfx.geometry_mode & (w0 & 0xFFFFFF)) | w1;
+                break;
+            case OP_SETOTHERMODE_H:
+                gfx_set_othermode(&gfx.othermode_h, w0, w1);
+                break;
+            case OP_SETOTHERMODE_L:
+                gfx_set_othermode(&gfx.othermode_l, w0, w1);
+                break;
+            case OP_RDPSETOTHERMODE:
+                gfx.othermode_h = w0 & 0xFFFFFF;
+                gfx.othermode_l = w1;
+                send_othermode();
+                break;
+            case OP_RDPHALF_1:
+                gfx.rdphalf_1 = w1;
+                break;
+            case OP_RDPHALF_2:
+                break;
+            case OP_BRANCH_Z: {
+                // Compared against the vertex's depth as the viewport left it, in 16.16
+                int index = (w0 & 0xFFF) / 2;
+                if (index < MAX_VERTICES && to_s16_16(gfx.vertices[index].screen[2] / 32.0f) <= (s32)w1) {
+                    pc = segmented_address(gfx.rdphalf_1);
+                }
+                break;
+            }
+            case OP_DL:
+                if (((w0 >> 16) & 0xFF) == 0) {
+                    if (gfx.dl_depth >= DL_STACK_SIZE) {
+                        logwarn("Graphics HLE: display list stack overflow");
+                        break;
+                    }
+                    gfx.dl_stack[gfx.dl_depth++] = pc;
+                }
+                pc = segmented_address(w1);
+                break;
+            case OP_ENDDL:
+                if (gfx.dl_depth == 0) {
+                    return;
+                }
+                pc = gfx.dl_stack[--gfx.dl_depth];
+                break;
+            case OP_TEXRECT: {
+                // The texture coordinates and their steps come in the two commands after
+                u32 command[4] = { w0, w1, hle_rdram_u32(pc + 4), hle_rdram_u32(pc + 12) };
+                pc += 16;
+                rsp_hle_gfx_rdp_command(4, command);
+                break;
+            }
+            case OP_RDP_ADDRESS: {
+                u32 command[2] = { w0, segmented_address(w1) };
+                rsp_hle_gfx_rdp_command(2, command);
+                break;
+            }
+            case OP_RDP: {
+                u32 command[2] = { w0, w1 };
+                rsp_hle_gfx_rdp_command(2, command);
+                break;
+            }
+            case OP_LOAD_UCODE: {
+                // Whatever's loaded next isn't necessarily something that can be run natively
+                static bool warned = false;
+                if (!warned) {
+                    logwarn("Graphics HLE: display list switches microcode, the rest of its frame won't be drawn");
+                    warned = true;
+                }
+                return;
+            }
+            case OP_UNSUPPORTED:
+            case OP_UNKNOWN:
+                warn_unsupported(opcode);
+                break;
+        }
+    }
+    logwarn("Graphics HLE: display list at 0x%08X didn't end, giving up", data_ptr);
+}
@@ -144,6 +144,7 @@ RSP_INSTR(rsp_spc_break) {
     N64RSP.status.halt = true;
     N64RSP.steps = 0;
     N64RSP.status.broke = true;
+    rsp_profiler_task_end(false);
 
     if (N64RSP.status.intr_on_break) {
         interrupt_raise(INTERRUPT_SP);
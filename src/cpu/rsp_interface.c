@@ -1,5 +1,8 @@
 #include "rsp_interface.h"
 #include "rsp.h"
+#include "rsp_hle.h"
+#include <system/rsp_ahead.h>
+#include <system/rsp_thread.h>
 
 typedef union sp_status_write {
     u32 raw;
@@ -47,6 +50,7 @@ void rsp_status_reg_write(u32 value) {
     sp_status_write_t write;
     write.raw = value;
 
+    bool was_halted = N64RSP.status.halt;
     CLEAR_SET(N64RSP.status.halt,          write.clear_halt,          write.set_halt);
     if (N64RSP.status.halt) {
         N64RSP.steps = 0;
@@ -69,9 +73,18 @@ void rsp_status_reg_write(u32 value) {
     CLEAR_SET(N64RSP.status.signal_5,      write.clear_signal_5,      write.set_signal_5);
     CLEAR_SET(N64RSP.status.signal_6,      write.clear_signal_6,      write.set_signal_6);
     CLEAR_SET(N64RSP.status.signal_7,      write.clear_signal_7,      write.set_signal_7);
+
+    if (was_halted && !N64RSP.status.halt) {
+        rsp_profiler_task_start();
+        rsp_hle_try_task();
+    } else if (!was_halted && N64RSP.status.halt) {
+        rsp_profiler_task_end(false);
+    }
 }
 
+// These are also called directly from compiled code, so they sync with the RSP thread themselves rather than the bus
 u32 read_word_spreg(u32 address) {
+    rsp_thread_sync();
     switch (address) {
         case ADDR_SP_MEM_ADDR_REG:
             return N64RSP.io.mem_addr.raw;
@@ -87,6 +100,7 @@ u32 read_word_spreg(u32 address) {
         case ADDR_SP_DMA_BUSY_REG:
             return 0; // DMA not busy, since it's instant.
         case ADDR_SP_SEMAPHORE_REG:
+            rsp_ahead_sync();
             return rsp_acquire_semaphore();
         default:
             logfatal("Reading word from unknown/unsupported address 0x%08X in region: REGION_SP_REGS", address);
@@ -94,6 +108,9 @@ u32 read_word_spreg(u32 address) {
 }
 
 void write_word_spreg(u32 address, u32 value) {
+    // Whatever the CPU is doing to the SP, it needs to see where the RSP really is first
+    rsp_thread_sync();
+    rsp_ahead_sync();
     switch (address) {
         case ADDR_SP_MEM_ADDR_REG:
             N64RSP.io.shadow_mem_addr.raw = value;
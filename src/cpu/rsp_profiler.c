@@ -0,0 +1,108 @@
+#include "rsp_profiler.h"
+
+#include <string.h>
+#include <log.h>
+#include "rsp.h"
+#include "rsp_hle.h"
+
+rsp_profiler_t rsp_profiler;
+
+void rsp_profiler_reset() {
+    bool enabled = rsp_profiler.enabled;
+    memset(&rsp_profiler, 0, sizeof(rsp_profiler));
+    rsp_profiler.enabled = enabled;
+}
+
+void rsp_profiler_set_enabled(bool enabled) {
+    if (enabled && !rsp_profiler.enabled) {
+        rsp_profiler_reset();
+    }
+    rsp_profiler.enabled = enabled;
+    if (!enabled) {
+        rsp_profiler.in_task = false;
+    }
+}
+
+void rsp_profiler_task_start() {
+    if (!rsp_profiler.enabled) {
+        return;
+    }
+    rsp_profiler.in_task = true;
+    memset(&rsp_profiler.current, 0, sizeof(rsp_profiler.current));
+    memset(rsp_profiler.current_pc_executions, 0, sizeof(rsp_profiler.current_pc_executions));
+    rsp_profiler.current.type = ostask_field(OSTASK_TYPE);
+    rsp_profiler.current.ucode = ostask_field(OSTASK_UCODE);
+}
+
+static rsp_profile_ucode_t* find_ucode(const rsp_profile_task_t* task) {
+    for (int i = 0; i < rsp_profiler.num_ucodes; i++) {
+        rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[i];
+        if (ucode->imem_hash == task->imem_hash && ucode->type == task->type && ucode->ucode == task->ucode && ucode->hle == task->hle) {
+            return ucode;
+        }
+    }
+    if (rsp_profiler.num_ucodes == RSP_PROFILER_MAX_UCODES) {
+        return NULL;
+    }
+    rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[rsp_profiler.num_ucodes++];
+    memset(ucode, 0, sizeof(rsp_profile_ucode_t));
+    ucode->imem_hash = task->imem_hash;
+    ucode->type = task->type;
+    ucode->ucode = task->ucode;
+    ucode->hle = task->hle;
+    return ucode;
+}
+
+void rsp_profiler_task_end(bool hle) {
+    if (!rsp_profiler.in_task) {
+        return;
+    }
+    rsp_profiler.in_task = false;
+
+    rsp_profile_task_t* task = &rsp_profiler.current;
+    task->hle = hle;
+    task->imem_hash = hle ? 0 : rsp_imem_hash();
+
+    rsp_profiler.recent[rsp_profiler.num_tasks % RSP_PROFILER_RECENT_TASKS] = *task;
+    rsp_profiler.num_tasks++;
+    rsp_profiler.cycles += task->cycles;
+
+    rsp_profile_ucode_t* ucode = find_ucode(task);
+    if (ucode == NULL) {
+        rsp_profiler.untracked_tasks++;
+        return;
+    }
+    ucode->tasks++;
+    ucode->cycles += task->cycles;
+    ucode->dma_bytes += task->dma_bytes;
+    for (int pc = 0; pc < RSP_PROFILER_NUM_PCS; pc++) {
+        ucode->pc_executions[pc] += rsp_profiler.current_pc_executions[pc];
+    }
+}
+
+void rsp_profiler_write_csv(FILE* fp) {
+    fprintf(fp, "record,imem_hash,type,ucode,hle,tasks,cycles,dma_bytes,pc,executions\n");
+
+    u64 num_recent = rsp_profiler.num_tasks < RSP_PROFILER_RECENT_TASKS ? rsp_profiler.num_tasks : RSP_PROFILER_RECENT_TASKS;
+    for (u64 i = rsp_profiler.num_tasks - num_recent; i < rsp_profiler.num_tasks; i++) {
+        rsp_profile_task_t* task = &rsp_profiler.recent[i % RSP_PROFILER_RECENT_TASKS];
+        fprintf(fp, "task,%016lX,%u,0x%08X,%d,1,%lu,%lu,,\n",
+                task->imem_hash, task->type, task->ucode, task->hle, task->cycles, task->dma_bytes);
+    }
+
+    for (int i = 0; i < rsp_profiler.num_ucodes; i++) {
+        rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[i];
+        fprintf(fp, "ucode,%016lX,%u,0x%08X,%d,%lu,%lu,%lu,,\n",
+                ucode->imem_hash, ucode->type, ucode->ucode, ucode->hle, ucode->tasks, ucode->cycles, ucode->dma_bytes);
+    }
+
+    for (int i = 0; i < rsp_profiler.num_ucodes; i++) {
+        rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[i];
+        for (int pc = 0; pc < RSP_PROFILER_NUM_PCS; pc++) {
+            if (ucode->pc_executions[pc] > 0) {
+                fprintf(fp, "pc,%016lX,%u,0x%08X,%d,,,,0x%03X,%lu\n",
+                        ucode->imem_hash, ucode->type, ucode->ucode, ucode->hle, pc << 2, ucode->pc_executions[pc]);
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef N64_RSP_PROFILER_H
+#define N64_RSP_PROFILER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <util.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opt-in accounting of where RSP time goes. A task runs from the CPU clearing halt until the microcode breaks (or the
+// CPU halts it again). Tasks are grouped by microcode: the OSTask's type and ucode pointer when the game uses libultra,
+// plus a hash of IMEM as it was when the task ended, since the boot microcode is all that's there when it starts.
+
+#define RSP_PROFILER_NUM_PCS (0x1000 / 4)
+#define RSP_PROFILER_MAX_UCODES 32
+#define RSP_PROFILER_RECENT_TASKS 256
+
+typedef struct rsp_profile_task {
+    u64 imem_hash; // 0 for tasks that were run natively, and never touched IMEM
+    u32 type;
+    u32 ucode;
+    bool hle;
+    u64 cycles;
+    u64 dma_bytes;
+} rsp_profile_task_t;
+
+typedef struct rsp_profile_ucode {
+    u64 imem_hash;
+    u32 type;
+    u32 ucode;
+    bool hle;
+    u64 tasks;
+    u64 cycles;
+    u64 dma_bytes;
+    u64 pc_executions[RSP_PROFILER_NUM_PCS];
+} rsp_profile_ucode_t;
+
+typedef struct rsp_profiler {
+    bool enabled;
+    bool in_task;
+
+    rsp_profile_task_t current;
+    u32 current_pc_executions[RSP_PROFILER_NUM_PCS];
+
+    u64 num_tasks;
+    u64 cycles;
+    rsp_profile_task_t recent[RSP_PROFILER_RECENT_TASKS]; // Ring buffer, the latest is at (num_tasks - 1)
+
+    int num_ucodes;
+    u64 untracked_tasks; // Ended after the ucode table filled up, so only in the totals
+    rsp_profile_ucode_t ucodes[RSP_PROFILER_MAX_UCODES];
+} rsp_profiler_t;
+
+extern rsp_profiler_t rsp_profiler;
+
+// Turning the profiler on starts again from nothing
+void rsp_profiler_set_enabled(bool enabled);
+void rsp_profiler_reset();
+
+void rsp_profiler_task_start();
+void rsp_profiler_task_end(bool hle);
+
+// One row per recent task, per microcode, and per microcode and PC, told apart by the first column
+void rsp_profiler_write_csv(FILE* fp);
+
+// Every instruction is counted as a cycle, the same as the RSP is stepped
+INLINE void rsp_profiler_count_pc(u16 pc) {
+    if (unlikely(rsp_profiler.in_task)) {
+        rsp_profiler.current_pc_executions[pc & (RSP_PROFILER_NUM_PCS - 1)]++;
+        rsp_profiler.current.cycles++;
+    }
+}
+
+INLINE void rsp_profiler_count_dma(u32 bytes) {
+    if (unlikely(rsp_profiler.in_task)) {
+        rsp_profiler.current.dma_bytes += bytes;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //N64_RSP_PROFILER_H
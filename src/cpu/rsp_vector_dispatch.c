@@ -0,0 +1,67 @@
+#include "rsp_vector_instructions.h"
+
+#include <log.h>
+
+#define SCALAR_KERNEL(NAME) .NAME = NAME##_scalar,
+#define SSE41_KERNEL(NAME) .NAME = NAME##_sse41,
+#define AVX2_KERNEL(NAME) .NAME = NAME##_avx2,
+
+static const rsp_vu_kernels_t kernel_sets[RSP_VU_NUM_KERNEL_SETS] = {
+        [RSP_VU_KERNELS_SCALAR] = { RSP_VU_INSTRUCTIONS(SCALAR_KERNEL) },
+        [RSP_VU_KERNELS_SSE41]  = { RSP_VU_INSTRUCTIONS(SSE41_KERNEL) },
+        [RSP_VU_KERNELS_AVX2]   = { RSP_VU_INSTRUCTIONS(AVX2_KERNEL) },
+};
+
+static const char* kernel_set_names[RSP_VU_NUM_KERNEL_SETS] = {
+        [RSP_VU_KERNELS_SCALAR] = "scalar",
+        [RSP_VU_KERNELS_SSE41]  = "SSE4.1",
+        [RSP_VU_KERNELS_AVX2]   = "AVX2",
+};
+
+// Safe everywhere until something picks a better set
+rsp_vu_kernels_t rsp_vu_kernels = { RSP_VU_INSTRUCTIONS(SCALAR_KERNEL) };
+
+#define FORWARD(NAME) RSP_VECTOR_INSTR(NAME) { rsp_vu_kernels.NAME(instruction); }
+RSP_VU_INSTRUCTIONS(FORWARD)
+
+bool rsp_vu_kernels_supported(rsp_vu_kernel_set_t set) {
+    switch (set) {
+        case RSP_VU_KERNELS_SCALAR:
+            return true;
+#ifdef N64_USE_SIMD
+        case RSP_VU_KERNELS_SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case RSP_VU_KERNELS_AVX2:
+            // Also checks the OS saves the upper halves of the registers
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* rsp_vu_kernel_set_name(rsp_vu_kernel_set_t set) {
+    return kernel_set_names[set];
+}
+
+void rsp_vu_use_kernels(rsp_vu_kernel_set_t set) {
+    if (!rsp_vu_kernels_supported(set)) {
+        logfatal("This CPU can't run the %s RSP vector unit kernels", kernel_set_names[set]);
+    }
+    rsp_vu_kernels = kernel_sets[set];
+}
+
+void rsp_vu_select_kernels() {
+#ifdef N64_USE_SIMD
+    __builtin_cpu_init();
+#endif
+    rsp_vu_kernel_set_t best = RSP_VU_KERNELS_SCALAR;
+    for (int set = RSP_VU_NUM_KERNEL_SETS - 1; set > RSP_VU_KERNELS_SCALAR; set--) {
+        if (rsp_vu_kernels_supported(set)) {
+            best = set;
+            break;
+        }
+    }
+    rsp_vu_use_kernels(best);
+    logalways("Using %s RSP vector unit kernels", kernel_set_names[best]);
+}
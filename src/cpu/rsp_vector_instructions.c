@@ -1,19 +1,30 @@
+// Built once per instruction set by the rsp_vector_instructions_*.c files, which set RSP_VU_SUFFIX and the features to
+// use. See rsp_vector_instructions.h.
+#ifndef RSP_VU_SUFFIX
+#error "Build one of the rsp_vector_instructions_*.c variants instead of this file"
+#endif
+
 #include "rsp_vector_instructions.h"
 
-#ifdef N64_USE_SIMD
-#include <emmintrin.h>
+#ifndef N64_USE_SIMD
+#undef RSP_VU_SIMD
+#undef RSP_VU_AVX2
 #endif
 
 #include <log.h>
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
 #include <immintrin.h>
-#include <n64_rsp_bus.h>
-
 #endif
+#include <stddef.h>
 #include "rsp.h"
 #include "rsp_rom.h"
 #include "n64_rsp_bus.h"
 
+#define RSP_VU_PASTE2(a, b) a##b
+#define RSP_VU_PASTE(a, b) RSP_VU_PASTE2(a, b)
+#undef RSP_VECTOR_INSTR
+#define RSP_VECTOR_INSTR(NAME) void RSP_VU_PASTE(NAME, RSP_VU_SUFFIX)(mips_instruction_t instruction)
+
 #define defvs vu_reg_t* vs = &N64RSP.vu_regs[instruction.cp2_vec.vs]
 #define defvt vu_reg_t* vt = &N64RSP.vu_regs[instruction.cp2_vec.vt]
 #define defvd vu_reg_t* vd = &N64RSP.vu_regs[instruction.cp2_vec.vd]
@@ -38,7 +49,37 @@ INLINE bool is_sign_extension(s16 high, s16 low) {
     return false;
 }
 
-#ifndef N64_USE_SIMD
+#ifdef RSP_VU_AVX2
+static_assert(offsetof(rsp_t, acc.m) == offsetof(rsp_t, acc.h) + sizeof(vu_reg_t), "acc.h and acc.m must be adjacent");
+
+// The high and middle accumulator lanes as 8 32 bit values
+INLINE __m256i get_acc_high_middle() {
+    __m128i lo = _mm_unpacklo_epi16(N64RSP.acc.m.single, N64RSP.acc.h.single);
+    __m128i hi = _mm_unpackhi_epi16(N64RSP.acc.m.single, N64RSP.acc.h.single);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Splits 8 32 bit values back into acc.h and acc.m, writing both at once
+INLINE void set_acc_high_middle(__m256i value) {
+    // Sign extending the low halves lets both be packed with signed saturation without anything saturating
+    __m256i middle = _mm256_srai_epi32(_mm256_slli_epi32(value, 16), 16);
+    __m256i high = _mm256_srai_epi32(value, 16);
+    // Packing works within each 128 bit half, so the 64 bit quarters come out as m0-3, h0-3, m4-7, h4-7
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(middle, high), 0b10001101);
+    _mm256_storeu_si256((__m256i*)&N64RSP.acc.h, packed);
+}
+
+// Signed 16 x 16 bit products of every lane, as 32 bit values
+INLINE __m256i multiply_signed_32(__m128i a, __m128i b) {
+    return _mm256_mullo_epi32(_mm256_cvtepi16_epi32(a), _mm256_cvtepi16_epi32(b));
+}
+
+INLINE __m128i clamp_32_to_16(__m256i value) {
+    return _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+}
+#endif
+
+#ifndef RSP_VU_SIMD
 INLINE vu_reg_t broadcast(vu_reg_t* vt, int lane0, int lane1, int lane2, int lane3, int lane4, int lane5, int lane6, int lane7) {
     vu_reg_t vte;
     vte.elements[VU_ELEM_INDEX(0)] = vt->elements[VU_ELEM_INDEX(lane0)];
@@ -59,42 +100,42 @@ INLINE vu_reg_t get_vte(vu_reg_t* vt, u8 e) {
         case 0 ... 1:
             return *vt;
         case 2:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b11110101), 0b11110101);
 #else
             vte = broadcast(vt, 0, 0, 2, 2, 4, 4, 6, 6);
 #endif
             break;
         case 3:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b10100000), 0b10100000);
 #else
             vte = broadcast(vt, 1, 1, 3, 3, 5, 5, 7, 7);
 #endif
             break;
         case 4:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b11111111), 0b11111111);
 #else
             vte = broadcast(vt, 0, 0, 0, 0, 4, 4, 4, 4);
 #endif
             break;
         case 5:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b10101010), 0b10101010);
 #else
             vte = broadcast(vt, 1, 1, 1, 1, 5, 5, 5, 5);
 #endif
             break;
         case 6:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b01010101), 0b01010101);
 #else
             vte = broadcast(vt, 2, 2, 2, 2, 6, 6, 6, 6);
 #endif
             break;
         case 7:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_shufflehi_epi16(_mm_shufflelo_epi16(vt->single, 0b00000000), 0b00000000);
 #else
             vte = broadcast(vt, 3, 3, 3, 3, 7, 7, 7, 7);
@@ -102,7 +143,7 @@ INLINE vu_reg_t get_vte(vu_reg_t* vt, u8 e) {
             break;
         case 8 ... 15: {
             int index = VU_ELEM_INDEX(e - 8);
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vte.single = _mm_set1_epi16(vt->elements[index]);
 #else
             for (int i = 0; i < 8; i++) {
@@ -120,9 +161,11 @@ INLINE vu_reg_t get_vte(vu_reg_t* vt, u8 e) {
 }
 
 
+#ifdef RSP_VU_BASELINE
 vu_reg_t ext_get_vte(vu_reg_t* vt, u8 e) {
     return get_vte(vt, e);
 }
+#endif
 
 
 #define SHIFT_AMOUNT_LBV_SBV 0
@@ -146,7 +189,7 @@ INLINE int sign_extend_7bit_offset(u8 offset, int shift_amount) {
     return uofs << shift_amount;
 }
 
-u32 rcp(s32 sinput) {
+static u32 rcp(s32 sinput) {
     // One's complement absolute value, xor with the sign bit to invert all bits if the sign bit is set
     s32 mask = sinput >> 31;
     s32 input = sinput ^ mask;
@@ -169,7 +212,7 @@ u32 rcp(s32 sinput) {
     return result;
 }
 
-u32 rsq(u32 input) {
+static u32 rsq(u32 input) {
     if (input == 0) {
         return 0x7FFFFFFF;
     } else if (input == 0xFFFF8000) {
@@ -653,7 +696,7 @@ RSP_VECTOR_INSTR(rsp_vec_vabs) {
     defvd;
     defvte;
 
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     // check if each element is zero
     __m128i vs_is_zero = _mm_cmpeq_epi16(vs->single, N64RSP.zero);
 
@@ -971,7 +1014,12 @@ RSP_VECTOR_INSTR(rsp_vec_vmadh) {
     defvs;
     defvd;
     defvte;
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_AVX2
+    // Adds to the top 32 bits of the accumulator, so the low lanes are left alone
+    __m256i acc = _mm256_add_epi32(get_acc_high_middle(), multiply_signed_32(vs->single, vte.single));
+    set_acc_high_middle(acc);
+    vd->single = clamp_32_to_16(acc);
+#elif defined(RSP_VU_SIMD)
     vecr lo, hi, omask;
     lo                 = _mm_mullo_epi16(vs->single, vte.single);
     hi                 = _mm_mulhi_epi16(vs->single, vte.single);
@@ -989,7 +1037,7 @@ RSP_VECTOR_INSTR(rsp_vec_vmadh) {
         s16 multiplicand1 = vte.elements[e];
         s16 multiplicand2 = vs->elements[e];
         s32 prod = multiplicand1 * multiplicand2;
-        word uprod = prod;
+        u32 uprod = prod;
 
         u64 acc_delta = (u64)uprod << 16;
         s64 acc = get_rsp_accumulator(e) + acc_delta;
@@ -1035,7 +1083,7 @@ RSP_VECTOR_INSTR(rsp_vec_vmadm) {
     defvs;
     defvd;
     defvte;
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     vecr lo, hi, sign, vta, omask;
     lo                 = _mm_mullo_epi16(vs->single, vte.single);
     hi                 = _mm_mulhi_epu16(vs->single, vte.single);
@@ -1081,7 +1129,7 @@ RSP_VECTOR_INSTR(rsp_vec_vmadn) {
     defvs;
     defvd;
     defvte;
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     vecr lo, hi, sign, vsa, omask, nhi, nmd, shi, smd, cmask, cval;
     lo                 = _mm_mullo_epi16(vs->single, vte.single);
     hi                 = _mm_mulhi_epu16(vs->single, vte.single);
@@ -1160,7 +1208,7 @@ RSP_VECTOR_INSTR(rsp_vec_vmov) {
     u8 de = instruction.cp2_vec.vs & 7;
 
     u16 vte_elem = vte.elements[VU_ELEM_INDEX(se)];
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     vd->elements[VU_ELEM_INDEX(de)] = vte_elem;
     N64RSP.acc.l = vte;
 #else
@@ -1191,6 +1239,12 @@ RSP_VECTOR_INSTR(rsp_vec_vmudh) {
     defvs;
     defvd;
     defvte;
+#ifdef RSP_VU_AVX2
+    __m256i product = multiply_signed_32(vs->single, vte.single);
+    set_acc_high_middle(product);
+    N64RSP.acc.l.single = _mm_setzero_si128();
+    vd->single = clamp_32_to_16(product);
+#else
     for (int e = 0; e < 8; e++) {
         s16 multiplicand1 = vte.elements[e];
         s16 multiplicand2 = vs->elements[e];
@@ -1205,6 +1259,7 @@ RSP_VECTOR_INSTR(rsp_vec_vmudh) {
 
         vd->elements[e] = result;
     }
+#endif
 }
 
 RSP_VECTOR_INSTR(rsp_vec_vmudl) {
@@ -1418,7 +1473,7 @@ RSP_VECTOR_INSTR(rsp_vec_vrcp) {
     vd->elements[VU_ELEM_INDEX(de)] = result & 0xFFFF;
     N64RSP.divout = (result >> 16) & 0xFFFF;
     N64RSP.divin_loaded = false;
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     N64RSP.acc.l.single = vte.single;
 #else
     for (int i = 0; i < 8; i++) {
@@ -1444,7 +1499,7 @@ RSP_VECTOR_INSTR(rsp_vec_vrcpl) {
     N64RSP.divout = (result >> 16) & 0xFFFF;
     N64RSP.divin = 0;
     N64RSP.divin_loaded = false;
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     N64RSP.acc.l.single = vte.single;
 #else
     for (int i = 0; i < 8; i++) {
@@ -1537,7 +1592,7 @@ RSP_VECTOR_INSTR(rsp_vec_vrsq) {
     N64RSP.divout = (result >> 16) & 0xFFFF;
     N64RSP.divin_loaded = false;
 
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     N64RSP.acc.l.single = vte.single;
 #else
     for (int i = 0; i < 8; i++) {
@@ -1554,7 +1609,7 @@ RSP_VECTOR_INSTR(rsp_vec_vrcph_vrsqh) {
     u8 e  = instruction.cp2_vec.e & 7;
     u8 de = instruction.cp2_vec.vs & 7;
 
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     N64RSP.acc.l.single = vte.single;
 #else
     for (int i = 0; i < 8; i++) {
@@ -1583,7 +1638,7 @@ RSP_VECTOR_INSTR(rsp_vec_vrsql) {
     N64RSP.divout = (result >> 16) & 0xFFFF;
     N64RSP.divin_loaded = false;
 
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
     N64RSP.acc.l.single = vte.single;
 #else
     for (int i = 0; i < 8; i++) {
@@ -1598,7 +1653,7 @@ RSP_VECTOR_INSTR(rsp_vec_vsar) {
     defvd;
     switch (instruction.cp2_vec.e) {
         case 0x8:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vd->single = N64RSP.acc.h.single;
 #else
             for (int i = 0; i < 8; i++) {
@@ -1607,7 +1662,7 @@ RSP_VECTOR_INSTR(rsp_vec_vsar) {
 #endif
             break;
         case 0x9:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vd->single = N64RSP.acc.m.single;
 #else
             for (int i = 0; i < 8; i++) {
@@ -1616,7 +1671,7 @@ RSP_VECTOR_INSTR(rsp_vec_vsar) {
 #endif
             break;
         case 0xA:
-#ifdef N64_USE_SIMD
+#ifdef RSP_VU_SIMD
             vd->single = N64RSP.acc.l.single;
 #else
             for (int i = 0; i < 8; i++) {
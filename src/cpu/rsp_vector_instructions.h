@@ -6,79 +6,110 @@
 
 #define RSP_VECTOR_INSTR(NAME) void NAME(mips_instruction_t instruction)
 
-RSP_VECTOR_INSTR(rsp_lwc2_lbv);
-RSP_VECTOR_INSTR(rsp_lwc2_ldv);
-RSP_VECTOR_INSTR(rsp_lwc2_lfv);
-RSP_VECTOR_INSTR(rsp_lwc2_lhv);
-RSP_VECTOR_INSTR(rsp_lwc2_llv);
-RSP_VECTOR_INSTR(rsp_lwc2_lpv);
-RSP_VECTOR_INSTR(rsp_lwc2_lqv);
-RSP_VECTOR_INSTR(rsp_lwc2_lrv);
-RSP_VECTOR_INSTR(rsp_lwc2_lsv);
-RSP_VECTOR_INSTR(rsp_lwc2_ltv);
-RSP_VECTOR_INSTR(rsp_lwc2_luv);
+#define RSP_VU_INSTRUCTIONS(X) \
+    X(rsp_lwc2_lbv) \
+    X(rsp_lwc2_ldv) \
+    X(rsp_lwc2_lfv) \
+    X(rsp_lwc2_lhv) \
+    X(rsp_lwc2_llv) \
+    X(rsp_lwc2_lpv) \
+    X(rsp_lwc2_lqv) \
+    X(rsp_lwc2_lrv) \
+    X(rsp_lwc2_lsv) \
+    X(rsp_lwc2_ltv) \
+    X(rsp_lwc2_luv) \
+    X(rsp_swc2_sbv) \
+    X(rsp_swc2_sdv) \
+    X(rsp_swc2_sfv) \
+    X(rsp_swc2_shv) \
+    X(rsp_swc2_slv) \
+    X(rsp_swc2_spv) \
+    X(rsp_swc2_sqv) \
+    X(rsp_swc2_srv) \
+    X(rsp_swc2_ssv) \
+    X(rsp_swc2_stv) \
+    X(rsp_swc2_suv) \
+    X(rsp_swc2_swv) \
+    X(rsp_cfc2) \
+    X(rsp_ctc2) \
+    X(rsp_mfc2) \
+    X(rsp_mtc2) \
+    X(rsp_vec_vabs) \
+    X(rsp_vec_vadd) \
+    X(rsp_vec_vaddc) \
+    X(rsp_vec_vand) \
+    X(rsp_vec_vch) \
+    X(rsp_vec_vcl) \
+    X(rsp_vec_vcr) \
+    X(rsp_vec_veq) \
+    X(rsp_vec_vge) \
+    X(rsp_vec_vlt) \
+    X(rsp_vec_vmacf) \
+    X(rsp_vec_vmacq) \
+    X(rsp_vec_vmacu) \
+    X(rsp_vec_vmadh) \
+    X(rsp_vec_vmadl) \
+    X(rsp_vec_vmadm) \
+    X(rsp_vec_vmadn) \
+    X(rsp_vec_vmov) \
+    X(rsp_vec_vmrg) \
+    X(rsp_vec_vmudh) \
+    X(rsp_vec_vmudl) \
+    X(rsp_vec_vmudm) \
+    X(rsp_vec_vmudn) \
+    X(rsp_vec_vmulf) \
+    X(rsp_vec_vmulq) \
+    X(rsp_vec_vmulu) \
+    X(rsp_vec_vnand) \
+    X(rsp_vec_vne) \
+    X(rsp_vec_vnop) \
+    X(rsp_vec_vnor) \
+    X(rsp_vec_vnxor) \
+    X(rsp_vec_vor) \
+    X(rsp_vec_vrcp) \
+    X(rsp_vec_vrcph_vrsqh) \
+    X(rsp_vec_vrcpl) \
+    X(rsp_vec_vrndn) \
+    X(rsp_vec_vrndp) \
+    X(rsp_vec_vrsq) \
+    X(rsp_vec_vrsql) \
+    X(rsp_vec_vsar) \
+    X(rsp_vec_vsub) \
+    X(rsp_vec_vsubc) \
+    X(rsp_vec_vxor) \
+    X(rsp_vec_vzero)
 
-RSP_VECTOR_INSTR(rsp_swc2_sbv);
-RSP_VECTOR_INSTR(rsp_swc2_sdv);
-RSP_VECTOR_INSTR(rsp_swc2_sfv);
-RSP_VECTOR_INSTR(rsp_swc2_shv);
-RSP_VECTOR_INSTR(rsp_swc2_slv);
-RSP_VECTOR_INSTR(rsp_swc2_spv);
-RSP_VECTOR_INSTR(rsp_swc2_sqv);
-RSP_VECTOR_INSTR(rsp_swc2_srv);
-RSP_VECTOR_INSTR(rsp_swc2_ssv);
-RSP_VECTOR_INSTR(rsp_swc2_stv);
-RSP_VECTOR_INSTR(rsp_swc2_suv);
-RSP_VECTOR_INSTR(rsp_swc2_swv);
+// rsp_vector_instructions.c is built once per instruction set: plain C, SSE4.1 and AVX2. rsp_vu_select_kernels() picks
+// the best one the host supports at startup.
+//
+// Each instruction's plain name (rsp_vec_vadd) runs whichever was picked. The decoder and the dynarec look up the picked
+// one directly with RSP_VU() instead, so it's called without going through the plain name. Anything that was decoded or
+// compiled has to be thrown away when the kernels are changed after that.
+#define RSP_VU_DECLARE(NAME) \
+    RSP_VECTOR_INSTR(NAME); \
+    RSP_VECTOR_INSTR(NAME##_scalar); \
+    RSP_VECTOR_INSTR(NAME##_sse41); \
+    RSP_VECTOR_INSTR(NAME##_avx2);
+RSP_VU_INSTRUCTIONS(RSP_VU_DECLARE)
 
-RSP_VECTOR_INSTR(rsp_cfc2);
-RSP_VECTOR_INSTR(rsp_ctc2);
-RSP_VECTOR_INSTR(rsp_mfc2);
-RSP_VECTOR_INSTR(rsp_mtc2);
+#define RSP_VU_KERNEL_FIELD(NAME) rspinstr_handler_t NAME;
+typedef struct rsp_vu_kernels {
+    RSP_VU_INSTRUCTIONS(RSP_VU_KERNEL_FIELD)
+} rsp_vu_kernels_t;
 
-RSP_VECTOR_INSTR(rsp_vec_vabs);
-RSP_VECTOR_INSTR(rsp_vec_vadd);
-RSP_VECTOR_INSTR(rsp_vec_vaddc);
-RSP_VECTOR_INSTR(rsp_vec_vand);
-RSP_VECTOR_INSTR(rsp_vec_vch);
-RSP_VECTOR_INSTR(rsp_vec_vcl);
-RSP_VECTOR_INSTR(rsp_vec_vcr);
-RSP_VECTOR_INSTR(rsp_vec_veq);
-RSP_VECTOR_INSTR(rsp_vec_vge);
-RSP_VECTOR_INSTR(rsp_vec_vlt);
-RSP_VECTOR_INSTR(rsp_vec_vmacf);
-RSP_VECTOR_INSTR(rsp_vec_vmacq);
-RSP_VECTOR_INSTR(rsp_vec_vmacu);
-RSP_VECTOR_INSTR(rsp_vec_vmadh);
-RSP_VECTOR_INSTR(rsp_vec_vmadl);
-RSP_VECTOR_INSTR(rsp_vec_vmadm);
-RSP_VECTOR_INSTR(rsp_vec_vmadn);
-RSP_VECTOR_INSTR(rsp_vec_vmov);
-RSP_VECTOR_INSTR(rsp_vec_vmrg);
-RSP_VECTOR_INSTR(rsp_vec_vmudh);
-RSP_VECTOR_INSTR(rsp_vec_vmudl);
-RSP_VECTOR_INSTR(rsp_vec_vmudm);
-RSP_VECTOR_INSTR(rsp_vec_vmudn);
-RSP_VECTOR_INSTR(rsp_vec_vmulf);
-RSP_VECTOR_INSTR(rsp_vec_vmulq);
-RSP_VECTOR_INSTR(rsp_vec_vmulu);
-RSP_VECTOR_INSTR(rsp_vec_vnand);
-RSP_VECTOR_INSTR(rsp_vec_vne);
-RSP_VECTOR_INSTR(rsp_vec_vnop);
-RSP_VECTOR_INSTR(rsp_vec_vnor);
-RSP_VECTOR_INSTR(rsp_vec_vnxor);
-RSP_VECTOR_INSTR(rsp_vec_vor);
-RSP_VECTOR_INSTR(rsp_vec_vrcp);
-RSP_VECTOR_INSTR(rsp_vec_vrcph_vrsqh);
-RSP_VECTOR_INSTR(rsp_vec_vrcpl);
-RSP_VECTOR_INSTR(rsp_vec_vrndn);
-RSP_VECTOR_INSTR(rsp_vec_vrndp);
-RSP_VECTOR_INSTR(rsp_vec_vrsq);
-RSP_VECTOR_INSTR(rsp_vec_vrsql);
-RSP_VECTOR_INSTR(rsp_vec_vsar);
-RSP_VECTOR_INSTR(rsp_vec_vsub);
-RSP_VECTOR_INSTR(rsp_vec_vsubc);
-RSP_VECTOR_INSTR(rsp_vec_vxor);
-RSP_VECTOR_INSTR(rsp_vec_vzero);
+typedef enum rsp_vu_kernel_set {
+    RSP_VU_KERNELS_SCALAR,
+    RSP_VU_KERNELS_SSE41,
+    RSP_VU_KERNELS_AVX2,
+    RSP_VU_NUM_KERNEL_SETS
+} rsp_vu_kernel_set_t;
+
+extern rsp_vu_kernels_t rsp_vu_kernels;
+#define RSP_VU(NAME) (rsp_vu_kernels.NAME)
+
+void rsp_vu_select_kernels();
+bool rsp_vu_kernels_supported(rsp_vu_kernel_set_t set);
+void rsp_vu_use_kernels(rsp_vu_kernel_set_t set);
+const char* rsp_vu_kernel_set_name(rsp_vu_kernel_set_t set);
 
 #endif //N64_RSP_VECTOR_INSTRUCTIONS_H
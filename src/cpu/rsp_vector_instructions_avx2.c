@@ -0,0 +1,6 @@
+// Built with -mavx2. The same as SSE4.1, but VEX encoded, and with the multiplies that work on acc.h and acc.m together
+// done 8 lanes at a time as 32 bit values.
+#define RSP_VU_SUFFIX _avx2
+#define RSP_VU_SIMD
+#define RSP_VU_AVX2
+#include "rsp_vector_instructions.c"
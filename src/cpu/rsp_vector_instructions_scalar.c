@@ -0,0 +1,4 @@
+// Plain C, for hosts without SSE4.1
+#define RSP_VU_SUFFIX _scalar
+#define RSP_VU_BASELINE
+#include "rsp_vector_instructions.c"
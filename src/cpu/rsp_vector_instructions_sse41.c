@@ -0,0 +1,4 @@
+// Built with -msse4.1
+#define RSP_VU_SUFFIX _sse41
+#define RSP_VU_SIMD
+#include "rsp_vector_instructions.c"
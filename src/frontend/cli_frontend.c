@@ -6,6 +6,9 @@
 #include <rdp/rdp.h>
 #include <rdp/parallel_rdp_wrapper.h>
 #include <frontend/tas_movie.h>
+#include <cpu/dynarec/dynarec_warm.h>
+#include <cpu/dynarec/dynarec_corpus.h>
+#include <cpu/dynarec/dynarec_memory_management.h>
 #include <signal.h>
 #include <imgui/imgui_ui.h>
 #include <settings.h>
@@ -45,6 +48,24 @@ int main(int argc, char** argv) {
     bool interpreter = false;
     cflags_add_bool(flags, 'i', "interpreter", &interpreter, "Force the use of the interpreter");
 
+    bool libultra_hle = false;
+    cflags_add_bool(flags, 'l', "hle-libultra", &libultra_hle, "Replace known libultra functions with native code. Faster, but less accurate");
+
+    bool hle_audio = false;
+    cflags_add_bool(flags, 'u', "hle-audio", &hle_audio, "Run the standard audio microcode natively instead of on the RSP. Faster, but resampling is slightly less accurate");
+
+    bool hle_gfx = false;
+    cflags_add_bool(flags, 'g', "hle-gfx", &hle_gfx, "Run the common graphics microcode (F3D, F3DEX, F3DEX2) natively instead of on the RSP. Faster, but less accurate");
+
+    bool rsp_thread = false;
+    cflags_add_bool(flags, 't', "rsp-thread", &rsp_thread, "Run the RSP on its own thread. Faster on multi-core hosts, but not deterministic. Ignored with the interpreter");
+
+    bool rsp_run_ahead = false;
+    cflags_add_bool(flags, 'c', "rsp-run-ahead", &rsp_run_ahead, "Run each RSP task to completion as soon as it starts, instead of alongside the CPU. Faster, ignored with --rsp-thread");
+
+    bool write_protect_code = false;
+    cflags_add_bool(flags, 'w', "write-protect-code", &write_protect_code, "Catch writes to compiled code with page protection instead of checking every store");
+
     bool software_mode = false;
     cflags_add_bool(flags, 's', "software-mode", &software_mode, "Use software mode RDP (UNFINISHED!)");
 
@@ -63,6 +84,12 @@ int main(int argc, char** argv) {
     const char* pif_rom_path = NULL;
     cflags_add_string(flags, 'p', "pif", &pif_rom_path, "Load PIF ROM");
 
+    const char* warm_blocks_path = NULL;
+    cflags_add_string(flags, 'a', "warm-blocks", &warm_blocks_path, "Compile the blocks listed by warm_block_list as soon as their page first runs. No code is precompiled");
+
+    const char* block_corpus_path = NULL;
+    cflags_add_string(flags, 'r', "record-blocks", &block_corpus_path, "Record every block the dynarec compiles, for compile_bench");
+
     cflags_parse(flags, argc, argv);
 
     if (help) {
@@ -99,6 +126,28 @@ int main(int argc, char** argv) {
         load_imgui_ui();
         register_imgui_event_handler(imgui_handle_event);
     }
+    n64sys.libultra_hle = libultra_hle;
+    n64sys.hle_audio = hle_audio;
+    n64sys.hle_gfx = hle_gfx;
+    n64sys.rsp_thread = rsp_thread;
+    if (rsp_run_ahead && rsp_thread && !interpreter) {
+        logwarn("Running the RSP on its own thread, ignoring --rsp-run-ahead");
+    } else {
+        n64sys.rsp_run_ahead = rsp_run_ahead;
+    }
+    if (write_protect_code && !interpreter) {
+        dynarec_enable_rdram_write_protection();
+    }
+    if (warm_blocks_path != NULL) {
+        if (n64sys.mem.rom.rom == NULL) {
+            logwarn("No ROM loaded, ignoring the warm block list");
+        } else {
+            dynarec_warm_load(warm_blocks_path, &n64sys.mem.rom);
+        }
+    }
+    if (block_corpus_path != NULL) {
+        dynarec_corpus_start_recording(block_corpus_path);
+    }
     if (tas_movie_path != NULL) {
         load_tas_movie(tas_movie_path);
     }
@@ -124,5 +173,6 @@ int main(int argc, char** argv) {
         prdp_update_screen_no_game();
     }
     n64_system_loop();
+    dynarec_corpus_stop_recording();
     n64_system_cleanup();
 }
\ No newline at end of file
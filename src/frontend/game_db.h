@@ -9,6 +9,7 @@ typedef struct gamedb_entry {
     const char* regions;
     n64_save_type_t save_type;
     const char* name;
+    bool libultra_hle_unsafe; // Known to break with libultra HLE, never enable it for this game
 } gamedb_entry_t;
 
 void gamedb_match(n64_system_t* system);
@@ -0,0 +1,164 @@
+#include "libultra_hle.h"
+
+#include <log.h>
+#include <mem/n64bus.h>
+#include <cpu/dynarec/dynarec.h>
+
+#define MIPS_REG_RA 31
+#define INSTR_JR_RA 0x03E00008
+
+// at, a0-a3, t0-t9. Callers can't expect these to survive a call, so it's fine if the native version doesn't set them.
+INLINE bool is_scratch_register(int reg) {
+    return reg == 0 || reg == 1 || (reg >= 4 && reg <= 15) || reg == 24 || reg == 25;
+}
+
+INLINE bool is_branch_in_function(mips_instruction_t instr, int index, int* target) {
+    switch (instr.op) {
+        case OPC_BEQ:
+        case OPC_BEQL:
+        case OPC_BNE:
+        case OPC_BNEL:
+        case OPC_BLEZ:
+        case OPC_BLEZL:
+        case OPC_BGTZ:
+        case OPC_BGTZL:
+            break;
+        case OPC_REGIMM:
+            if (instr.i.rt != RT_BLTZ && instr.i.rt != RT_BLTZL && instr.i.rt != RT_BGEZ && instr.i.rt != RT_BGEZL) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    s16 offset = instr.i.immediate;
+    *target = index + 1 + offset;
+    return true;
+}
+
+// Instructions that only touch registers (or the cache, which isn't emulated), and which register they write.
+INLINE bool is_register_only(mips_instruction_t instr, int* written) {
+    switch (instr.op) {
+        case OPC_CACHE:
+            *written = 0;
+            return true;
+        case OPC_LUI:
+        case OPC_ADDIU:
+        case OPC_ANDI:
+        case OPC_ORI:
+        case OPC_XORI:
+        case OPC_SLTI:
+        case OPC_SLTIU:
+            *written = instr.i.rt;
+            return true;
+        case OPC_SPCL:
+            switch (instr.r.funct) {
+                case FUNCT_SLL:
+                case FUNCT_SRL:
+                case FUNCT_ADDU:
+                case FUNCT_SUBU:
+                case FUNCT_AND:
+                case FUNCT_OR:
+                case FUNCT_XOR:
+                case FUNCT_NOR:
+                case FUNCT_SLT:
+                case FUNCT_SLTU:
+                    *written = instr.r.rd;
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+/*
+ * osInvalDCache, osInvalICache, osWritebackDCache and osWritebackDCacheAll all have the same shape across libultra
+ * versions: some address arithmetic, a loop running a cache op over every line in the range, and a return. There are
+ * no loads or stores, and only scratch registers are written. Since cache ops are no-ops here, the only visible
+ * difference between running the function and returning straight away is in registers the caller can't rely on.
+ */
+static int match_cache_maintenance(u32 physical_address) {
+    bool has_cache_op = false;
+    int branch_targets[LIBULTRA_HLE_MAX_LENGTH];
+    int num_branches = 0;
+
+    for (int i = 0; i < LIBULTRA_HLE_MAX_LENGTH; i++) {
+        u32 address = physical_address + i * 4;
+        // Keep the whole function in one page, so invalidating that page is enough to drop the replacement.
+        if (i > 0 && (address & (BLOCKCACHE_PAGE_SIZE - 1)) == 0) {
+            return 0;
+        }
+
+        mips_instruction_t instr;
+        instr.raw = n64_read_physical_word(address);
+        int written;
+        int target;
+
+        if (instr.raw == INSTR_JR_RA) {
+            // Needs its delay slot to be in the page as well
+            u32 delay_slot = address + 4;
+            if ((delay_slot & (BLOCKCACHE_PAGE_SIZE - 1)) == 0) {
+                return 0;
+            }
+            instr.raw = n64_read_physical_word(delay_slot);
+            if (!is_register_only(instr, &written) || !is_scratch_register(written) || !has_cache_op) {
+                return 0;
+            }
+
+            int length = i + 2;
+            for (int b = 0; b < num_branches; b++) {
+                if (branch_targets[b] < 0 || branch_targets[b] >= length) {
+                    return 0;
+                }
+            }
+            return length;
+        } else if (is_branch_in_function(instr, i, &target)) {
+            branch_targets[num_branches++] = target;
+        } else if (is_register_only(instr, &written) && is_scratch_register(written)) {
+            has_cache_op |= instr.op == OPC_CACHE;
+        } else {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+// Leave the CPU in the state it would be in right after the function's jr $ra and delay slot.
+static int hle_return(u64 function_address, int length) {
+    N64CPU.prev_pc = function_address + (length - 1) * 4;
+    N64CPU.pc = N64CPU.gpr[MIPS_REG_RA];
+    N64CPU.next_pc = N64CPU.pc + 4;
+    N64CPU.branch = false;
+    N64CPU.prev_branch = true;
+    return length;
+}
+
+/*
+ * Functions are matched by the shape of their code rather than by hashing it, so the same entry covers every libultra
+ * version and every link address. Anything added here has to be exact in the side effects visible to the caller
+ * (memory, non-scratch registers, the return value in v0/v1), and should check as much of the code as it needs to be
+ * sure of that.
+ *
+ * Only the cache maintenance functions are here so far. bcopy, bzero and memcpy aren't: their byte-wise head and tail
+ * handling differs between libultra versions and writes memory, so a shape match isn't enough to replace them safely.
+ * Their word loops still run natively through the loop idioms in cpu/dynarec/dynarec_idioms.c.
+ */
+static const libultra_hle_entry_t libultra_hle_catalogue[] = {
+        {"cache maintenance (osInvalDCache/osInvalICache/osWritebackDCache/osWritebackDCacheAll)", match_cache_maintenance, hle_return},
+};
+
+#define LIBULTRA_HLE_CATALOGUE_SIZE (sizeof(libultra_hle_catalogue) / sizeof(libultra_hle_entry_t))
+
+const libultra_hle_entry_t* libultra_hle_match(u32 physical_address, int* length) {
+    for (int i = 0; i < LIBULTRA_HLE_CATALOGUE_SIZE; i++) {
+        int matched_length = libultra_hle_catalogue[i].matcher(physical_address);
+        if (matched_length > 0) {
+            logdebug("HLE: 0x%08X is %s", physical_address, libultra_hle_catalogue[i].name);
+            *length = matched_length;
+            return &libultra_hle_catalogue[i];
+        }
+    }
+    return NULL;
+}
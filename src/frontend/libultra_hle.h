@@ -0,0 +1,26 @@
+#ifndef N64_LIBULTRA_HLE_H
+#define N64_LIBULTRA_HLE_H
+
+#include <system/n64system.h>
+
+// Longest guest function the matchers will look at, in instructions
+#define LIBULTRA_HLE_MAX_LENGTH 64
+
+// Checks whether the function starting at physical_address is this entry. Returns its length in instructions, or 0.
+typedef int (*libultra_hle_matcher_t)(u32 physical_address);
+// Runs in place of the whole function, including the return to the caller. Returns the number of guest instructions to charge.
+typedef int (*libultra_hle_handler_t)(u64 function_address, int length);
+
+typedef struct libultra_hle_entry {
+    const char* name;
+    libultra_hle_matcher_t matcher;
+    libultra_hle_handler_t handler;
+} libultra_hle_entry_t;
+
+INLINE bool libultra_hle_enabled() {
+    return n64sys.libultra_hle && !n64sys.mem.rom.libultra_hle_unsafe;
+}
+
+const libultra_hle_entry_t* libultra_hle_match(u32 physical_address, int* length);
+
+#endif //N64_LIBULTRA_HLE_H
@@ -14,6 +14,8 @@
 #include <mem/pif.h>
 #include <mem/mem_util.h>
 #include <cpu/dynarec/dynarec.h>
+#include <cpu/rsp_profiler.h>
+#include <log.h>
 #include <frontend/audio.h>
 #include <frontend/render.h>
 
@@ -54,6 +56,8 @@ struct RingBuffer {
 
 RingBuffer<double> frame_times;
 RingBuffer<ImU64> block_complilations;
+RingBuffer<double> block_compilation_times;
+RingBuffer<ImU64> block_invalidations;
 RingBuffer<ImU64> rsp_steps;
 RingBuffer<ImU64> codecache_bytes_used;
 RingBuffer<ImU64> audiostream_bytes_available;
@@ -145,8 +149,112 @@ void render_menubar() {
     }
 }
 
+static const char* rsp_task_type_name(u32 type) {
+    switch (type) {
+        case 1: return "Graphics";
+        case 2: return "Audio";
+        case 3: return "Video";
+        case 4: return "JPEG";
+        default: return "Other";
+    }
+}
+
+void render_rsp_profile() {
+    if (!ImGui::CollapsingHeader("RSP Tasks")) {
+        return;
+    }
+
+    bool enabled = rsp_profiler.enabled;
+    if (ImGui::Checkbox("Profile RSP tasks (runs the RSP interpreted while on)", &enabled)) {
+        rsp_profiler_set_enabled(enabled);
+    }
+    if (!rsp_profiler.enabled) {
+        return;
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        rsp_profiler_reset();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save as CSV")) {
+        FILE* fp = fopen("rsp_profile.csv", "w");
+        if (fp) {
+            rsp_profiler_write_csv(fp);
+            fclose(fp);
+            logalways("Saved the RSP profile to rsp_profile.csv");
+        } else {
+            logwarn("Unable to open rsp_profile.csv for writing");
+        }
+    }
+
+    ImGui::Text("%lu tasks, %lu cycles", rsp_profiler.num_tasks, rsp_profiler.cycles);
+    if (rsp_profiler.untracked_tasks > 0) {
+        ImGui::Text("%lu tasks ran after the microcode table filled up, and are only in the totals", rsp_profiler.untracked_tasks);
+    }
+
+    static int selected = -1;
+    if (ImGui::BeginTable("RSP microcodes", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("IMEM hash");
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Ucode");
+        ImGui::TableSetupColumn("Tasks");
+        ImGui::TableSetupColumn("Cycles");
+        ImGui::TableSetupColumn("Cycles / task");
+        ImGui::TableSetupColumn("DMA bytes");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < rsp_profiler.num_ucodes; i++) {
+            rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            char label[32];
+            if (ucode->hle) {
+                snprintf(label, sizeof(label), "HLE##%d", i);
+            } else {
+                snprintf(label, sizeof(label), "%016lX##%d", ucode->imem_hash, i);
+            }
+            if (ImGui::Selectable(label, selected == i, ImGuiSelectableFlags_SpanAllColumns)) {
+                selected = i;
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", rsp_task_type_name(ucode->type));
+            ImGui::TableNextColumn();
+            ImGui::Text("0x%08X", ucode->ucode);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lu", ucode->tasks);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lu (%.1f%%)", ucode->cycles, rsp_profiler.cycles ? 100.0 * ucode->cycles / rsp_profiler.cycles : 0.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lu", ucode->tasks ? ucode->cycles / ucode->tasks : 0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lu", ucode->dma_bytes);
+        }
+        ImGui::EndTable();
+    }
+
+    if (selected >= 0 && selected < rsp_profiler.num_ucodes) {
+        rsp_profile_ucode_t* ucode = &rsp_profiler.ucodes[selected];
+        static double executions[RSP_PROFILER_NUM_PCS];
+        double max = 0;
+        for (int pc = 0; pc < RSP_PROFILER_NUM_PCS; pc++) {
+            executions[pc] = ucode->pc_executions[pc];
+            if (executions[pc] > max) {
+                max = executions[pc];
+            }
+        }
+        ImPlot::SetNextPlotLimitsY(0, max, ImGuiCond_Always, 0);
+        ImPlot::SetNextPlotLimitsX(0, RSP_PROFILER_NUM_PCS, ImGuiCond_Always);
+        if (ImPlot::BeginPlot("Executions per instruction (IMEM address / 4)")) {
+            ImPlot::PlotBars("Executions", executions, RSP_PROFILER_NUM_PCS, 1.0);
+            ImPlot::EndPlot();
+        }
+    }
+}
+
 void render_metrics_window() {
     block_complilations.add_point(get_metric(METRIC_BLOCK_COMPILATION));
+    block_compilation_times.add_point(get_metric(METRIC_BLOCK_COMPILATION_NS) / 1000000.0);
+    block_invalidations.add_point(get_metric(METRIC_BLOCK_INVALIDATION));
     rsp_steps.add_point(get_metric(METRIC_RSP_STEPS));
     double frametime = 1000.0f / ImGui::GetIO().Framerate;
     frame_times.add_point(frametime);
@@ -187,6 +295,32 @@ void render_metrics_window() {
         ImPlot::EndPlot();
     }
 
+    ImGui::Text("Block compilation time this frame: %.3f ms (%ld guest instructions, %ld host bytes)",
+                get_metric(METRIC_BLOCK_COMPILATION_NS) / 1000000.0,
+                get_metric(METRIC_BLOCK_GUEST_INSTRUCTIONS),
+                get_metric(METRIC_BLOCK_HOST_BYTES));
+    ImPlot::SetNextPlotLimitsY(0, block_compilation_times.max(), ImGuiCond_Always, 0);
+    ImPlot::SetNextPlotLimitsX(0, METRICS_HISTORY_ITEMS, ImGuiCond_Always);
+    if (ImPlot::BeginPlot("Block Compilation Time Per Frame")) {
+        ImPlot::PlotLine("Compilation Time (ms)", block_compilation_times.data, METRICS_HISTORY_ITEMS, 1, 0, block_compilation_times.offset);
+        ImPlot::EndPlot();
+    }
+
+    ImGui::Text("Hot blocks recompiled this frame: %ld", get_metric(METRIC_BLOCK_HOT_RECOMPILATION));
+    ImGui::Text("Block page invalidations this frame: %ld", get_metric(METRIC_BLOCK_INVALIDATION));
+    ImGui::Text("Pages pinned to the interpreter this frame: %ld", get_metric(METRIC_BLOCK_PAGE_PINNED));
+    ImGui::Text("Instructions interpreted on pinned pages this frame: %ld", get_metric(METRIC_BLOCK_PINNED_INSTRUCTIONS));
+    ImPlot::SetNextPlotLimitsY(0, block_invalidations.max(), ImGuiCond_Always, 0);
+    ImPlot::SetNextPlotLimitsX(0, METRICS_HISTORY_ITEMS, ImGuiCond_Always);
+    if (ImPlot::BeginPlot("Block Page Invalidations Per Frame")) {
+        ImPlot::PlotBars("Page invalidations", block_invalidations.data, METRICS_HISTORY_ITEMS, 1, 0, block_invalidations.offset);
+        ImPlot::EndPlot();
+    }
+
+    if (ImGui::Button("Dump block stats to stdout")) {
+        n64_dynarec_dump_block_stats(stdout, 0);
+    }
+
     ImPlot::SetNextPlotLimitsY(0, n64sys.dynarec->codecache_size, ImGuiCond_Always, 0);
     ImPlot::SetNextPlotLimitsX(0, METRICS_HISTORY_ITEMS, ImGuiCond_Always);
     if (ImPlot::BeginPlot("Codecache bytes used")) {
@@ -216,6 +350,8 @@ void render_metrics_window() {
         ImPlot::EndPlot();
     }
 
+    render_rsp_profile();
+
     ImGui::End();
 }
 
@@ -6,6 +6,8 @@
 #include <rdp/rdp.h>
 #include <cpu/dynarec/dynarec.h>
 #include <rsp.h>
+#include <system/rsp_thread.h>
+#include <system/rsp_ahead.h>
 #include <interface/si.h>
 #include <interface/pi.h>
 
@@ -298,6 +300,8 @@ void n64_write_physical_dword(u32 address, u64 value) {
         case REGION_RDRAM_UNUSED:
             return;
         case REGION_SP_MEM: {
+            rsp_thread_sync();
+            rsp_ahead_sync();
             value >>= 32; // TODO: this is probably wrong, it probably depends on the address.
             if (address & 0x1000) {
                 word_to_byte_array((u8*) &N64RSP.sp_imem, DWORD_ADDRESS(address & 0xFFF), value);
@@ -368,6 +372,7 @@ u64 n64_read_physical_dword(u32 address) {
         case REGION_RDRAM_REGS:
             logfatal("Reading dword from address 0x%08X in unsupported region: REGION_RDRAM_REGS", address);
         case REGION_SP_MEM:
+            rsp_thread_sync();
             if (address & 0x1000) {
                 return dword_from_byte_array((u8*) &N64RSP.sp_imem, DWORD_ADDRESS(address & 0xFFF));
             } else {
@@ -427,6 +432,8 @@ void n64_write_physical_word(u32 address, u32 value) {
         case REGION_RDRAM_UNUSED:
             return;
         case REGION_SP_MEM:
+            rsp_thread_sync();
+            rsp_ahead_sync();
             if (address & 0x1000) {
                 word_to_byte_array((u8*) &N64RSP.sp_imem, WORD_ADDRESS(address & 0xFFF), value);
                 invalidate_rsp_icache(WORD_ADDRESS(address));
@@ -497,6 +504,7 @@ u32 n64_read_physical_word(u32 address) {
         case REGION_RDRAM_REGS:
             return read_word_rdramreg(address);
         case REGION_SP_MEM:
+            rsp_thread_sync();
             if (address & 0x1000) {
                 return word_from_byte_array((u8*) &N64RSP.sp_imem, WORD_ADDRESS(address & 0xFFF));
             } else {
@@ -580,6 +588,8 @@ void n64_write_physical_half(u32 address, u32 value) {
         case REGION_RDRAM_UNUSED:
             return;
         case REGION_SP_MEM:
+            rsp_thread_sync();
+            rsp_ahead_sync();
             value = bus_edge_case_half_pif_spmem(address, value);
             address &= ~3;
             if (address & 0x1000) {
@@ -653,6 +663,7 @@ u16 n64_read_physical_half(u32 address) {
         case REGION_RDRAM_REGS:
             logfatal("Reading u16 from address 0x%08X in unsupported region: REGION_RDRAM_REGS", address);
         case REGION_SP_MEM:
+            rsp_thread_sync();
             if (address & 0x1000) {
                 return half_from_byte_array((u8*) &N64RSP.sp_imem, HALF_ADDRESS(address & 0xFFF));
             } else {
@@ -705,6 +716,8 @@ void n64_write_physical_byte(u32 address, u32 value) {
         case REGION_RDRAM_REGS:
             logfatal("Writing byte 0x%02X to address 0x%08X in unsupported region: REGION_RDRAM_REGS", value & 0xFF, address);
         case REGION_SP_MEM:
+            rsp_thread_sync();
+            rsp_ahead_sync();
             value = value << (8 * (3 - (address & 3)));
             address = (address & 0xFFF) & ~3;
             if (address & 0x1000) {
@@ -765,6 +778,7 @@ u8 n64_read_physical_byte(u32 address) {
         case REGION_RDRAM_REGS:
             logfatal("Reading byte from address 0x%08X in unsupported region: REGION_RDRAM_REGS", address);
         case REGION_SP_MEM:
+            rsp_thread_sync();
             if (address & 0x1000) {
                 return N64RSP.sp_imem[BYTE_ADDRESS(address) - SREGION_SP_IMEM];
             } else {
@@ -155,6 +155,22 @@ INLINE bool resolve_virtual_address(u64 virtual, bus_access_t bus_access, u32* p
     }
 }
 
+// For callers that were specialised for a mode, so the checks above fold away
+INLINE bool resolve_virtual_address_in_mode(u64 virtual, bus_access_t bus_access, u32* physical, r4300i_addressing_mode_t mode) {
+    switch (mode) {
+        case ADDRESSING_MODE_KERNEL_32:
+            return resolve_virtual_address_32bit(virtual, bus_access, physical);
+        case ADDRESSING_MODE_KERNEL_64:
+            return resolve_virtual_address_64bit(virtual, bus_access, physical);
+        case ADDRESSING_MODE_USER_32:
+            return resolve_virtual_address_user_32bit(virtual, bus_access, physical);
+        case ADDRESSING_MODE_USER_64:
+            return resolve_virtual_address_user_64bit(virtual, bus_access, physical);
+        default:
+            return resolve_virtual_address(virtual, bus_access, physical);
+    }
+}
+
 INLINE u32 resolve_virtual_address_or_die(u64 virtual, bus_access_t bus_access) {
     u32 physical;
     if (!resolve_virtual_address(virtual, bus_access, &physical)) {
@@ -175,6 +191,13 @@ u16 n64_read_physical_half(u32 address);
 void n64_write_physical_byte(u32 address, u32 value);
 u8 n64_read_physical_byte(u32 address);
 
+u32 read_word_rdramreg(u32 address);
+void write_word_rdramreg(u32 address, u32 value);
+u32 read_word_rireg(u32 address);
+void write_word_rireg(u32 address, u32 value);
+u32 read_word_mireg(u32 address);
+void write_word_mireg(u32 address, u32 value);
+
 INLINE void n64_write_word(u64 address, u32 value) {
     n64_write_physical_word(resolve_virtual_address_or_die(address, true), value);
 }
@@ -39,6 +39,7 @@ typedef struct n64_rom {
     n64_cic_type_t cic_type;
     char game_name_cartridge[20];
     const char* game_name_db;
+    bool libultra_hle_unsafe;
     char code[4];
     bool pal;
 } n64_rom_t;
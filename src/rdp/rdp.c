@@ -17,6 +17,7 @@
 #include <frontend/render.h>
 #include <rsp.h>
 #include <frontend/frontend.h>
+#include <system/rsp_thread.h>
 
 static void* plugin_handle = NULL;
 static u32 rdram_size_word = N64_RDRAM_SIZE; // GFX_INFO needs this to be sent as a uint32
@@ -62,7 +63,10 @@ void rdp_check_interrupts() {
     on_interrupt_change();
 }
 
+// Only the CPU calls these, the RSP goes through its CP0 registers. Compiled code calls them directly, not through the
+// bus, so they wait for the RSP thread themselves.
 void write_word_dpcreg(u32 address, u32 value) {
+    rsp_thread_sync();
     switch (address) {
         case ADDR_DPC_START_REG:
             rdp_start_reg_write(value);
@@ -94,6 +98,7 @@ void write_word_dpcreg(u32 address, u32 value) {
 }
 
 u32 read_word_dpcreg(u32 address) {
+    rsp_thread_sync();
     switch (address) {
         case ADDR_DPC_START_REG:
             return n64sys.dpc.start;
@@ -242,6 +247,17 @@ void process_rdp_list() {
     dpc->status.freeze = false;
 }
 
+void rdp_run_hle_command(int command_length, u32* buffer) {
+    u8 command = (buffer[0] >> 24) & 0x3F;
+    if (command >= 8) {
+        rdp_enqueue_command(command_length, buffer);
+    }
+
+    if (command == RDP_COMMAND_FULL_SYNC) {
+        rdp_on_full_sync();
+    }
+}
+
 void rdp_run_command() {
     if (n64sys.dpc.status.freeze) {
         return;
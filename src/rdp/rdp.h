@@ -10,6 +10,8 @@ void load_rdp_plugin(const char* filename);
 void write_word_dpcreg(u32 address, u32 value);
 u32 read_word_dpcreg(u32 address);
 void rdp_run_command();
+// Sends a command straight to the RDP, bypassing the DPC registers. For graphics microcode run natively.
+void rdp_run_hle_command(int command_length, u32* buffer);
 void rdp_update_screen();
 void rdp_status_reg_write(u32 value);
 void rdp_start_reg_write(u32 value);
@@ -8,6 +8,7 @@
 #include <interface/vi.h>
 #include <interface/ai.h>
 #include <cpu/rsp.h>
+#include <cpu/rsp_vector_instructions.h>
 #include <cpu/dynarec/dynarec.h>
 #ifndef N64_WIN
 #include <sys/mman.h>
@@ -25,6 +26,8 @@
 #include <interface/pi.h>
 #include <dynarec/rsp_dynarec.h>
 #include <mem/pif.h>
+#include "rsp_thread.h"
+#include "rsp_ahead.h"
 
 static bool should_quit = false;
 
@@ -110,6 +113,7 @@ void init_n64system(const char* rom_path, bool enable_frontend, bool enable_debu
 
     mprotect_codecache();
     n64sys.dynarec = n64_dynarec_init(codecache, CODECACHE_SIZE);
+    rsp_vu_select_kernels();
     N64RSP.dynarec = rsp_dynarec_init(rsp_codecache, RSP_CODECACHE_SIZE);
 
     if (enable_frontend) {
@@ -186,6 +190,8 @@ void reset_n64system() {
     invalidate_dynarec_all_pages(n64sys.dynarec);
 
     scheduler_reset();
+    rsp_ahead_reset();
+    r4300i_schedule_compare_interrupt();
 }
 
 INLINE int jit_system_step() {
@@ -205,19 +211,17 @@ INLINE int jit_system_step() {
             return CYCLES_PER_INSTR;
         }
     }
-    static int cpu_steps = 0;
     int taken = n64_dynarec_step();
-    {
-        uint64_t oldcount = N64CP0.count >> 1;
-        uint64_t newcount = (N64CP0.count + (taken * CYCLES_PER_INSTR)) >> 1;
-        if (unlikely(oldcount < N64CP0.compare && newcount >= N64CP0.compare)) {
-            N64CP0.cause.ip7 = true;
-            loginfo("Compare interrupt! oldcount: 0x%08lX newcount: 0x%08lX compare 0x%08X", oldcount, newcount, N64CP0.compare);
-            r4300i_interrupt_update();
-        }
-        N64CP0.count += taken;
-        N64CP0.count &= 0x1FFFFFFFF;
+    if (n64sys.rsp_thread) {
+        rsp_thread_step(taken);
+        return taken;
     }
+    if (n64sys.rsp_run_ahead) {
+        rsp_ahead_step(taken, true);
+        return taken;
+    }
+
+    static int cpu_steps = 0;
     cpu_steps += taken;
 
     if (!N64RSP.status.halt) {
@@ -250,6 +254,10 @@ INLINE int interpreter_system_step() {
 #endif
     int taken = CYCLES_PER_INSTR;
     r4300i_step();
+    if (n64sys.rsp_run_ahead) {
+        rsp_ahead_step(taken, false);
+        return taken;
+    }
     static int cpu_steps = 0;
     cpu_steps += taken;
 
@@ -279,6 +287,12 @@ void handle_scheduler_event(scheduler_event_t* event) {
         case SCHEDULER_PI_BUS_WRITE_COMPLETE:
             on_pi_write_complete();
             break;
+        case SCHEDULER_COMPARE_INTERRUPT:
+            r4300i_on_compare_interrupt();
+            break;
+        case SCHEDULER_RSP_AHEAD:
+            rsp_ahead_on_scheduler_event();
+            break;
         default:
             logfatal("");
     }
@@ -318,6 +332,7 @@ void jit_system_loop() {
                 break;
 
             case N64_ACTION_RESET:
+                rsp_thread_sync();
                 reset_n64system();
                 n64_load_rom(n64sys.rom_path);
                 pif_rom_execute();
@@ -346,6 +361,8 @@ void jit_system_loop() {
                 }
                 cycles -= n64sys.vi.cycles_per_halfline;
             }
+            // Everything the RSP did this frame needs to be in before it gets shown
+            rsp_thread_sync();
             check_vi_interrupt();
             rdp_update_screen();
 
@@ -420,7 +437,11 @@ void n64_system_loop() {
     if (n64sys.use_interpreter) {
         interpreter_system_loop();
     } else {
+        if (n64sys.rsp_thread) {
+            rsp_thread_start();
+        }
         jit_system_loop();
+        rsp_thread_stop();
     }
 }
 
@@ -452,6 +473,14 @@ void on_interrupt_change() {
 }
 
 void interrupt_raise(n64_interrupt_t interrupt) {
+    if (unlikely(on_rsp_thread)) {
+        rsp_thread_defer_interrupt(interrupt, true);
+        return;
+    }
+    if (unlikely(rsp_ahead_running)) {
+        rsp_ahead_defer_interrupt(interrupt, true);
+        return;
+    }
     switch (interrupt) {
         case INTERRUPT_VI:
             loginfo("Raising VI interrupt");
@@ -490,6 +519,14 @@ void interrupt_raise(n64_interrupt_t interrupt) {
 }
 
 void interrupt_lower(n64_interrupt_t interrupt) {
+    if (unlikely(on_rsp_thread)) {
+        rsp_thread_defer_interrupt(interrupt, false);
+        return;
+    }
+    if (unlikely(rsp_ahead_running)) {
+        rsp_ahead_defer_interrupt(interrupt, false);
+        return;
+    }
     switch (interrupt) {
         case INTERRUPT_VI:
             n64sys.mi.intr.vi = false;
@@ -11,6 +11,7 @@ extern "C" {
 #include <debugger/debugger.h>
 #include <debugger/debugger_types.h>
 #include <rdp/softrdp.h>
+#include <system/scheduler.h>
 
 #define CPU_HERTZ 93750000
 #define CPU_CYCLES_PER_FRAME (CPU_HERTZ / n64sys.target_fps)
@@ -134,14 +135,33 @@ typedef enum n64_action {
     N64_ACTION_RESET
 } n64_action_t;
 
+// Laid out hot to cold. The fields looked at on every step come first, then the register blocks of the various
+// interfaces, and the big buffers (RDRAM and the ROM, the software RDP, the debugger, paths) go last.
 typedef struct n64_system {
-    n64_mem_t mem;
-    n64_video_type_t video_type;
+    n64_dynarec_t *dynarec;
+    bool use_interpreter;
+    bool libultra_hle; // Replace known libultra functions with native code, see frontend/libultra_hle.c
+    bool hle_audio; // Run known audio microcode natively instead of on the RSP, see cpu/rsp_hle.h
+    bool hle_gfx; // Run known graphics microcode natively, sending its output straight to the RDP, see cpu/rsp_hle_gfx.c
+    bool rsp_thread; // Run the RSP on its own thread with the dynarec, see system/rsp_thread.h
+    bool rsp_run_ahead; // Run each RSP task to completion when it starts, see system/rsp_ahead.h
     struct {
         u32 init_mode;
         mi_intr_mask_t intr_mask;
         mi_intr_t intr;
     } mi;
+    struct {
+        bool dma_busy;
+        bool dma_to_dram;
+    } si;
+    struct {
+        bool dma_busy;
+        bool io_busy;
+
+        u32 latch;
+    } pi;
+    n64_action_t action_queued;
+
     struct {
         vi_status_t status;
         u32 vi_origin;
@@ -178,34 +198,31 @@ typedef struct n64_system {
             u32 precision;
         } dac;
     } ai;
-    struct {
-        bool dma_busy;
-        bool dma_to_dram;
-    } si;
-    struct {
-        bool dma_busy;
-        bool io_busy;
-
-        u32 latch;
-    } pi;
     n64_dpc_t dpc;
+    n64_video_type_t video_type;
+    unsigned target_fps;
+
+    n64_mem_t mem;
+    softrdp_state_t softrdp_state;
 #ifndef N64_WIN
     n64_debugger_state_t debugger_state;
 #endif
-    n64_dynarec_t *dynarec;
-    softrdp_state_t softrdp_state;
-    bool use_interpreter;
     char rom_path[PATH_MAX];
-    n64_action_t action_queued;
-    unsigned target_fps;
 } n64_system_t;
 
+#define N64_SYSTEM_HOT_BYTES 64
+ASSERTWITHIN(n64_system_t, dynarec, N64_SYSTEM_HOT_BYTES);
+ASSERTWITHIN(n64_system_t, use_interpreter, N64_SYSTEM_HOT_BYTES);
+ASSERTWITHIN(n64_system_t, mi, N64_SYSTEM_HOT_BYTES);
+ASSERTWITHIN(n64_system_t, pi, N64_SYSTEM_HOT_BYTES);
+
 void init_n64system(const char* rom_path, bool enable_frontend, bool enable_debug, n64_video_type_t video_type, bool use_interpreter);
 void reset_n64system();
 bool n64_should_quit();
 void n64_load_rom(const char* rom_path);
 
 void n64_system_step(bool dynarec);
+void handle_scheduler_event(scheduler_event_t* event);
 void n64_system_loop();
 void n64_system_cleanup();
 void n64_request_quit();
@@ -0,0 +1,178 @@
+#include "rsp_ahead.h"
+
+#include <string.h>
+#include <log.h>
+#include <cpu/rsp.h>
+#include "scheduler.h"
+
+#define MAX_DEFERRED_INTERRUPTS 32
+
+bool rsp_ahead_pending = false;
+bool rsp_ahead_running = false;
+
+typedef struct deferred_interrupt {
+    u64 time; // Steps into the task while it's running, scheduler ticks after
+    bool at_break;
+    n64_interrupt_t interrupt;
+    bool raise;
+} deferred_interrupt_t;
+
+static deferred_interrupt_t deferred[MAX_DEFERRED_INTERRUPTS];
+static int num_deferred = 0;
+static int first_deferred = 0;
+
+// What the task left behind, while DMEM and the status show what it started with
+static bool holding_result = false;
+static u64 result_time;
+static u8 result_dmem[SP_DMEM_SIZE];
+static rsp_status_t result_status;
+
+static bool task_running = false;
+static int cpu_steps = 0;
+
+void rsp_ahead_reset() {
+    rsp_ahead_pending = false;
+    rsp_ahead_running = false;
+    num_deferred = 0;
+    first_deferred = 0;
+    holding_result = false;
+    task_running = false;
+    cpu_steps = 0;
+}
+
+static void show_result() {
+    holding_result = false;
+    memcpy(N64RSP.sp_dmem, result_dmem, SP_DMEM_SIZE);
+    N64RSP.status = result_status;
+}
+
+static void deliver(deferred_interrupt_t* entry) {
+    if (entry->raise) {
+        interrupt_raise(entry->interrupt);
+    } else {
+        interrupt_lower(entry->interrupt);
+    }
+}
+
+static void schedule_next() {
+    scheduler_remove_event(SCHEDULER_RSP_AHEAD);
+    rsp_ahead_pending = holding_result || first_deferred < num_deferred;
+    if (!rsp_ahead_pending) {
+        num_deferred = 0;
+        first_deferred = 0;
+        return;
+    }
+
+    u64 next = holding_result ? result_time : UINT64_MAX;
+    if (first_deferred < num_deferred && deferred[first_deferred].time < next) {
+        next = deferred[first_deferred].time;
+    }
+    scheduler_enqueue_absolute(next, SCHEDULER_RSP_AHEAD);
+}
+
+void rsp_ahead_on_scheduler_event() {
+    // Past the time, but in the same order they'd have happened in
+    while (first_deferred < num_deferred && deferred[first_deferred].time <= scheduler_ticks) {
+        deliver(&deferred[first_deferred++]);
+    }
+    if (holding_result && result_time <= scheduler_ticks) {
+        show_result();
+    }
+    schedule_next();
+}
+
+void rsp_ahead_flush() {
+    while (first_deferred < num_deferred) {
+        deliver(&deferred[first_deferred++]);
+    }
+    if (holding_result) {
+        show_result();
+    }
+    schedule_next();
+}
+
+void rsp_ahead_defer_interrupt(n64_interrupt_t interrupt, bool raise) {
+    if (num_deferred == MAX_DEFERRED_INTERRUPTS) {
+        logwarn("RSP task raised too many interrupts to hold back, letting this one through early");
+        rsp_ahead_running = false;
+        if (raise) {
+            interrupt_raise(interrupt);
+        } else {
+            interrupt_lower(interrupt);
+        }
+        rsp_ahead_running = true;
+        return;
+    }
+    deferred_interrupt_t* entry = &deferred[num_deferred++];
+    // The break has already zeroed the steps left, so its time isn't known until the run is over. Compiled blocks only
+    // count their steps once they're done, so anything else is off by at most the rest of its block.
+    entry->at_break = N64RSP.status.halt;
+    entry->time = RSP_AHEAD_MAX_STEPS - N64RSP.steps;
+    entry->interrupt = interrupt;
+    entry->raise = raise;
+}
+
+// Returns true if the task finished
+static bool run_task(bool dynarec) {
+    static u8 start_dmem[SP_DMEM_SIZE];
+    memcpy(start_dmem, N64RSP.sp_dmem, SP_DMEM_SIZE);
+    rsp_status_t start_status = N64RSP.status;
+    int first_new = num_deferred;
+
+    rsp_ahead_running = true;
+    N64RSP.steps = RSP_AHEAD_MAX_STEPS;
+    int ran = dynarec ? rsp_dynarec_run() : rsp_run();
+    rsp_ahead_running = false;
+    N64RSP.steps = 0;
+
+    // 2 RSP steps per 3 CPU steps
+    u64 end_time = scheduler_ticks + (u64)ran * 3 / 2;
+    for (int i = first_new; i < num_deferred; i++) {
+        deferred[i].time = deferred[i].at_break ? end_time : scheduler_ticks + deferred[i].time * 3 / 2;
+    }
+
+    bool finished = N64RSP.status.halt;
+    if (finished) {
+        holding_result = true;
+        result_time = end_time;
+        memcpy(result_dmem, N64RSP.sp_dmem, SP_DMEM_SIZE);
+        result_status = N64RSP.status;
+        memcpy(N64RSP.sp_dmem, start_dmem, SP_DMEM_SIZE);
+        N64RSP.status = start_status;
+        schedule_next();
+    } else {
+        logwarn("RSP task still running after %d steps, carrying on with it alongside the CPU", RSP_AHEAD_MAX_STEPS);
+        rsp_ahead_flush();
+    }
+    return finished;
+}
+
+void rsp_ahead_step(int cpu_cycles, bool dynarec) {
+    if (holding_result || N64RSP.status.halt) {
+        // Finished already, even if the CPU can't see that yet
+        task_running = false;
+        N64RSP.steps = 0;
+        cpu_steps = 0;
+        return;
+    }
+
+    if (!task_running) {
+        task_running = true;
+        if (run_task(dynarec)) {
+            task_running = false;
+            return;
+        }
+    }
+
+    cpu_steps += cpu_cycles;
+    // 2 RSP steps per 3 CPU steps
+    while (cpu_steps > 2) {
+        N64RSP.steps += 2;
+        cpu_steps -= 3;
+    }
+    if (dynarec) {
+        rsp_dynarec_run();
+    } else {
+        rsp_run();
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef N64_RSP_AHEAD_H
+#define N64_RSP_AHEAD_H
+
+#include <util.h>
+#include <stdbool.h>
+#include <system/n64system.h>
+
+// With n64sys.rsp_run_ahead set, the RSP runs each task to completion as soon as the CPU starts it, rather than being
+// given 2 steps for every 3 CPU steps alongside it. Most games start a task and leave the SP alone until the interrupt
+// comes in, so this trades thousands of short RSP runs for one.
+//
+// The CPU still sees the task take as long as it would have. Until then, DMEM and SP_STATUS read as they did when the
+// task started, and interrupts the RSP raised or lowered (the SP interrupt from its break, the DP one from the RDP) are
+// held back and delivered at the cycle they would have happened. Anything the CPU writes to the SP (its registers, the
+// status, DMEM/IMEM) or the semaphore it takes means it's talking to the task, so everything held back is let through
+// right away first.
+//
+// A task that hasn't broken after this many steps is probably waiting on the CPU, so it carries on interleaved.
+// RDRAM and the RDP see what the RSP did straight away, same as with the RSP thread.
+#define RSP_AHEAD_MAX_STEPS 2000000
+
+// Something the CPU shouldn't see yet is being held back
+extern bool rsp_ahead_pending;
+// The RSP is running a task ahead of the CPU right now
+extern bool rsp_ahead_running;
+
+void rsp_ahead_step(int cpu_cycles, bool dynarec);
+void rsp_ahead_reset();
+void rsp_ahead_on_scheduler_event();
+void rsp_ahead_defer_interrupt(n64_interrupt_t interrupt, bool raise);
+void rsp_ahead_flush();
+
+// Lets the CPU see everything the RSP has done
+INLINE void rsp_ahead_sync() {
+    if (unlikely(rsp_ahead_pending)) {
+        rsp_ahead_flush();
+    }
+}
+
+#endif //N64_RSP_AHEAD_H
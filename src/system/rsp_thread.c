@@ -0,0 +1,157 @@
+#include "rsp_thread.h"
+
+#include <string.h>
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <log.h>
+#include <mem/n64mem.h>
+#include <cpu/rsp.h>
+#include <cpu/dynarec/dynarec.h>
+
+#define RSP_THREAD_NUM_PAGES (N64_RDRAM_SIZE / BLOCKCACHE_PAGE_SIZE)
+#define MAX_DEFERRED_INTERRUPTS 64
+
+bool rsp_thread_busy = false;
+_Thread_local bool on_rsp_thread = false;
+
+static SDL_Thread* thread = NULL;
+static SDL_sem* work_ready;
+static SDL_sem* work_done;
+static bool quitting = false;
+
+// CPU cycles run since the RSP was last handed steps
+static int cpu_steps = 0;
+
+typedef struct deferred_interrupt {
+    n64_interrupt_t interrupt;
+    bool raise;
+} deferred_interrupt_t;
+
+// Written by the RSP thread while it's busy, applied by the CPU thread once it's done.
+// Interrupts are kept in the order the RSP raised and lowered them, so a raise followed by a lower still gets raised.
+static deferred_interrupt_t deferred_interrupts[MAX_DEFERRED_INTERRUPTS];
+static int num_deferred_interrupts = 0;
+static u64 deferred_pages[RSP_THREAD_NUM_PAGES / 64];
+static bool any_deferred = false;
+
+static int rsp_thread_main(void* unused) {
+    on_rsp_thread = true;
+    while (true) {
+        SDL_SemWait(work_ready);
+        if (quitting) {
+            break;
+        }
+        rsp_dynarec_run();
+        SDL_SemPost(work_done);
+    }
+    return 0;
+}
+
+void rsp_thread_start() {
+    if (thread != NULL) {
+        return;
+    }
+    work_ready = SDL_CreateSemaphore(0);
+    work_done = SDL_CreateSemaphore(0);
+    quitting = false;
+    thread = SDL_CreateThread(rsp_thread_main, "RSP", NULL);
+    if (thread == NULL) {
+        logfatal("Unable to start the RSP thread: %s", SDL_GetError());
+    }
+    logalways("Running the RSP on its own thread");
+}
+
+void rsp_thread_stop() {
+    if (thread == NULL) {
+        return;
+    }
+    rsp_thread_sync();
+    quitting = true;
+    SDL_SemPost(work_ready);
+    SDL_WaitThread(thread, NULL);
+    SDL_DestroySemaphore(work_ready);
+    SDL_DestroySemaphore(work_done);
+    thread = NULL;
+}
+
+static void apply_deferred() {
+    any_deferred = false;
+    for (int i = 0; i < num_deferred_interrupts; i++) {
+        if (deferred_interrupts[i].raise) {
+            interrupt_raise(deferred_interrupts[i].interrupt);
+        } else {
+            interrupt_lower(deferred_interrupts[i].interrupt);
+        }
+    }
+    num_deferred_interrupts = 0;
+
+    for (int i = 0; i < RSP_THREAD_NUM_PAGES / 64; i++) {
+        while (deferred_pages[i] != 0) {
+            int bit = __builtin_ctzll(deferred_pages[i]);
+            deferred_pages[i] &= deferred_pages[i] - 1;
+            invalidate_dynarec_page((i * 64 + bit) * BLOCKCACHE_PAGE_SIZE);
+        }
+    }
+}
+
+void rsp_thread_wait() {
+    SDL_SemWait(work_done);
+    rsp_thread_busy = false;
+    if (any_deferred) {
+        apply_deferred();
+    }
+}
+
+void rsp_thread_step(int cpu_cycles) {
+    cpu_steps += cpu_cycles;
+    if (likely(cpu_steps < RSP_THREAD_QUANTUM / 2 * 3)) {
+        return;
+    }
+
+    rsp_thread_sync();
+    if (N64RSP.status.halt) {
+        N64RSP.steps = 0;
+        cpu_steps = 0;
+        return;
+    }
+
+    // 2 RSP steps per 3 CPU steps
+    N64RSP.steps += cpu_steps / 3 * 2;
+    cpu_steps %= 3;
+    rsp_thread_busy = true;
+    SDL_SemPost(work_ready);
+}
+
+// Keeps only the last change to each interrupt, in the order they happened
+static void collapse_deferred_interrupts() {
+    int kept = 0;
+    for (int i = 0; i < num_deferred_interrupts; i++) {
+        bool changed_again = false;
+        for (int j = i + 1; j < num_deferred_interrupts; j++) {
+            changed_again |= deferred_interrupts[j].interrupt == deferred_interrupts[i].interrupt;
+        }
+        if (!changed_again) {
+            deferred_interrupts[kept++] = deferred_interrupts[i];
+        }
+    }
+    num_deferred_interrupts = kept;
+}
+
+void rsp_thread_defer_interrupt(n64_interrupt_t interrupt, bool raise) {
+    if (num_deferred_interrupts == MAX_DEFERRED_INTERRUPTS) {
+        // Nothing can be applied until the CPU thread picks these up. The interrupts still end up in the right state,
+        // only the pulses in between are lost.
+        logwarn("RSP raised and lowered too many interrupts in one batch, dropping the ones it changed again");
+        collapse_deferred_interrupts();
+    }
+    deferred_interrupts[num_deferred_interrupts].interrupt = interrupt;
+    deferred_interrupts[num_deferred_interrupts].raise = raise;
+    num_deferred_interrupts++;
+    any_deferred = true;
+}
+
+void rsp_thread_defer_invalidation(u32 physical_address) {
+    u32 page = (physical_address & (N64_RDRAM_SIZE - 1)) / BLOCKCACHE_PAGE_SIZE;
+    deferred_pages[page / 64] |= 1ULL << (page % 64);
+    any_deferred = true;
+}
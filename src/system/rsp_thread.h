@@ -0,0 +1,44 @@
+#ifndef N64_RSP_THREAD_H
+#define N64_RSP_THREAD_H
+
+#include <util.h>
+#include <stdbool.h>
+#include <system/n64system.h>
+
+// With n64sys.rsp_thread set, the RSP runs on its own thread instead of being stepped along with the CPU.
+//
+// The CPU still decides how far the RSP gets: as it runs, it owes the RSP 2 steps for every 3 of its own, same as
+// when they're interleaved. Once it owes this many, it waits for the RSP to finish its last batch and hands it the next.
+// The RSP then runs them while the CPU carries on.
+#define RSP_THREAD_QUANTUM 0x2000
+
+// The CPU also waits for the RSP to finish its batch before anything that could see what it's done: SP and DP register
+// accesses (the semaphore and status included), DMEM/IMEM accesses, and the end of each frame. Interrupts the RSP raises
+// or lowers, in the order it did so, and CPU code it overwrites by DMA take effect at that point, on the CPU thread.
+//
+// This is NOT deterministic, and is off unless asked for with --rsp-thread:
+// - RSP DMA to and from RDRAM runs while the CPU carries on, so it races with the CPU's own loads and stores there. A
+//   game that watches RDRAM for the RSP's output, rather than waiting for the SP interrupt or polling the status, can
+//   see it at a different point each run.
+// - Display lists the RSP sends to the RDP are processed on the RSP thread as well, with the same race on the frame
+//   buffer and everything else the RDP reads or writes in RDRAM.
+
+extern bool rsp_thread_busy;
+extern _Thread_local bool on_rsp_thread;
+
+void rsp_thread_start();
+void rsp_thread_stop();
+void rsp_thread_step(int cpu_cycles);
+void rsp_thread_wait();
+
+void rsp_thread_defer_interrupt(n64_interrupt_t interrupt, bool raise);
+void rsp_thread_defer_invalidation(u32 physical_address);
+
+// Waits for the RSP to finish the steps it's been given, if it's running
+INLINE void rsp_thread_sync() {
+    if (unlikely(rsp_thread_busy)) {
+        rsp_thread_wait();
+    }
+}
+
+#endif //N64_RSP_THREAD_H
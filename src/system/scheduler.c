@@ -29,6 +29,7 @@ void free_event_node(scheduler_event_node_t* node) {
 
 void scheduler_reset() {
     scheduler_ticks = 0;
+    scheduler_list = NULL;
     free_event_nodes_stack_ptr = 0;
 
     for (int i = 0; i < NUM_EVENT_NODES; i++) {
@@ -56,8 +57,9 @@ void scheduler_enqueue_absolute(u64 at_ticks, scheduler_event_type_t event_type)
     ins->event.type = event_type;
     ins->event.time = at_ticks;
 
-    // special case when list is empty
-    if (scheduler_list == NULL) {
+    // special case when list is empty, or the new event is due before everything in it
+    if (scheduler_list == NULL || at_ticks < scheduler_list->event.time) {
+        ins->next = scheduler_list;
         scheduler_list = ins;
     } else {
         // Find the first node with a rank smaller than the node we're inserting
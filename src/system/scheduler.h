@@ -7,7 +7,9 @@
 typedef enum scheduler_event_type {
     SCHEDULER_SI_DMA_COMPLETE,
     SCHEDULER_PI_DMA_COMPLETE,
-    SCHEDULER_PI_BUS_WRITE_COMPLETE
+    SCHEDULER_PI_BUS_WRITE_COMPLETE,
+    SCHEDULER_COMPARE_INTERRUPT,
+    SCHEDULER_RSP_AHEAD
 } scheduler_event_type_t;
 
 typedef struct scheduler_event {
@@ -15,6 +17,8 @@ typedef struct scheduler_event {
     scheduler_event_type_t type;
 } scheduler_event_t;
 
+// Cycles run since the last reset
+extern u64 scheduler_ticks;
 
 void scheduler_reset();
 bool scheduler_tick(u64 cycles, scheduler_event_t* event);
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cflags.h>
+#include <log.h>
+#include <metrics.h>
+#include <system/n64system.h>
+#include <mem/n64bus.h>
+#include <cpu/dynarec/dynarec.h>
+#include <cpu/dynarec/dynarec_corpus.h>
+
+// Blocks recorded outside of RDRAM (e.g. running from the cartridge) get replayed from these two pages instead,
+// at the same offset. Two, because a block's delay slot can be in the next page.
+#define SCRATCH_PAGES (N64_RDRAM_SIZE - 2 * BLOCKCACHE_PAGE_SIZE)
+
+void usage(cflags_t* flags) {
+    cflags_print_usage(flags,
+                       "[OPTION]... FILE",
+                       "Compiles every block in a corpus recorded with --record-blocks, and reports how fast the dynarec did it",
+                       "https://github.com/Dillonb/n64");
+}
+
+u64 timestamp_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+u32 replay_address(const dynarec_corpus_entry_t* entry) {
+    if (entry->physical_address + entry->guest_length * 4 <= SCRATCH_PAGES) {
+        return entry->physical_address;
+    }
+    return SCRATCH_PAGES + (entry->physical_address & (BLOCKCACHE_PAGE_SIZE - 1));
+}
+
+int main(int argc, char** argv) {
+    cflags_t* flags = cflags_init();
+    cflags_flag_t * verbose = cflags_add_bool(flags, 'v', "verbose", NULL, "enables verbose output, repeat up to 4 times for more verbosity");
+
+    int iterations = 10;
+    cflags_add_int(flags, 'n', "iterations", &iterations, "number of times to compile the whole corpus");
+
+    cflags_parse(flags, argc, argv);
+
+    if (flags->argc != 1 || iterations < 1) {
+        usage(flags);
+        return 1;
+    }
+
+    log_set_verbosity(verbose->count);
+
+    u32 num_blocks;
+    dynarec_corpus_block_t* blocks = dynarec_corpus_load(flags->argv[0], &num_blocks);
+    if (blocks == NULL || num_blocks == 0) {
+        logdie("No blocks to compile in %s", flags->argv[0]);
+    }
+
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+
+    u64 compile_ns = 0;
+    u64 guest_instructions = 0;
+    reset_all_metrics();
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (u32 i = 0; i < num_blocks; i++) {
+            const dynarec_corpus_entry_t* entry = &blocks[i].entry;
+            u32 physical = replay_address(entry);
+            for (u32 word = 0; word < entry->guest_length; word++) {
+                n64_write_physical_word(physical + word * 4, blocks[i].code[word]);
+            }
+            N64CP0.status.raw = entry->cp0_status;
+            cp0_status_updated();
+
+            u64 start = timestamp_ns();
+            guest_instructions += n64_dynarec_compile_block(entry->virtual_address, physical);
+            compile_ns += timestamp_ns() - start;
+        }
+    }
+
+    u64 blocks_compiled = (u64)num_blocks * iterations;
+    u64 host_bytes = get_metric(METRIC_BLOCK_HOST_BYTES);
+    double seconds = compile_ns / 1e9;
+    printf("Compiled %lu blocks (%u in the corpus, %d iterations) in %.3f s\n", blocks_compiled, num_blocks, iterations, seconds);
+    printf("%.0f blocks/s\n", blocks_compiled / seconds);
+    printf("%.0f guest instructions/s\n", guest_instructions / seconds);
+    printf("%lu host bytes emitted, %.1f per block, %.2f per guest instruction\n",
+           host_bytes, (double)host_bytes / blocks_compiled, (double)host_bytes / guest_instructions);
+
+    dynarec_corpus_free(blocks, num_blocks);
+    cflags_free(flags);
+    return 0;
+}
@@ -325,18 +325,12 @@ void cpu_step(r4300i_t* cpu) {
     cpu->exception = false; // only used in dynarec
 }
 
+// Count and the compare interrupt are driven by the scheduler
 void update_count(int taken) {
-    r4300i_t* cpu = &N64CPU;
-
-    uint64_t oldcount = cpu->cp0.count >> 1;
-    uint64_t newcount = (cpu->cp0.count + (taken * CYCLES_PER_INSTR)) >> 1;
-    if (unlikely(oldcount < cpu->cp0.compare && newcount >= cpu->cp0.compare)) {
-        cpu->cp0.cause.ip7 = true;
-        loginfo("Compare interrupt!");
-        r4300i_interrupt_update(cpu);
+    scheduler_event_t event;
+    if (scheduler_tick(taken, &event)) {
+        handle_scheduler_event(&event);
     }
-    cpu->cp0.count += taken;
-
 }
 
 int run_system_check_interrupt() {
@@ -345,7 +339,7 @@ int run_system_check_interrupt() {
     if (unlikely(cpu->interrupts > 0)) {
         if(cpu->cp0.status.ie && !cpu->cp0.status.exl && !cpu->cp0.status.erl) {
             r4300i_handle_exception(cpu->pc, EXCEPTION_INTERRUPT, 0);
-            cpu->cp0.count += CYCLES_PER_INSTR;
+            update_count(CYCLES_PER_INSTR);
             printf("Interrupt!\n");
             return CYCLES_PER_INSTR;
         }
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cflags.h>
+#include <log.h>
+#include <system/n64system.h>
+#include <cpu/rsp.h>
+#include <cpu/rsp_vector_instructions.h>
+#include <cpu/dynarec/rsp_dynarec.h>
+#include <cpu/disassemble.h>
+
+// Runs random vector unit instructions on random states through every set of kernels the host can run and through the
+// dynarec, and reports anywhere they don't match the plain C kernels. No hardware involved, so this says nothing about
+// whether any of them are right, only that they agree. tools/rsp_fuzzer.c compares against a real console.
+
+typedef struct vu_state {
+    u32 gpr[32];
+    vu_reg_t vu_regs[32];
+    vu_reg_t vcc_l, vcc_h;
+    vu_reg_t vco_l, vco_h;
+    vu_reg_t vce;
+    vu_reg_t acc_h, acc_m, acc_l;
+    s16 divin;
+    bool divin_loaded;
+    s16 divout;
+    u8 dmem[SP_DMEM_SIZE];
+} vu_state_t;
+
+static const int load_store_functs[] = {
+        LWC2_LBV, LWC2_LDV, LWC2_LFV, LWC2_LHV, LWC2_LLV, LWC2_LPV,
+        LWC2_LQV, LWC2_LRV, LWC2_LSV, LWC2_LTV, LWC2_LUV
+};
+#define NUM_LOAD_STORE_FUNCTS (sizeof(load_store_functs) / sizeof(load_store_functs[0]))
+
+static const int regmove_functs[] = { COP_MF, COP_CF, COP_MT, COP_CT };
+
+void usage(cflags_t* flags) {
+    cflags_print_usage(flags,
+                       "[OPTION]...",
+                       "Checks the RSP vector unit kernels and the RSP dynarec against the plain C kernels on random instructions and states",
+                       "https://github.com/Dillonb/n64");
+}
+
+u16 random_element() {
+    // Lean on the values where saturation and carries go wrong
+    switch (rand() % 8) {
+        case 0: return 0x0000;
+        case 1: return 0x7FFF;
+        case 2: return 0x8000;
+        case 3: return 0xFFFF;
+        default: return rand() & 0xFFFF;
+    }
+}
+
+void random_vu_reg(vu_reg_t* reg) {
+    for (int e = 0; e < 8; e++) {
+        reg->elements[e] = random_element();
+    }
+}
+
+void random_flag_reg(vu_reg_t* reg) {
+    u16 bits = rand() & 0xFFFF;
+    for (int e = 0; e < 8; e++) {
+        reg->elements[e] = FLAGREG_BOOL(bits & (1 << e));
+    }
+}
+
+void random_state(vu_state_t* state) {
+    for (int i = 0; i < 32; i++) {
+        state->gpr[i] = i == 0 ? 0 : ((u32)rand() << 16) ^ rand();
+        random_vu_reg(&state->vu_regs[i]);
+    }
+    random_flag_reg(&state->vcc_l);
+    random_flag_reg(&state->vcc_h);
+    random_flag_reg(&state->vco_l);
+    random_flag_reg(&state->vco_h);
+    random_flag_reg(&state->vce);
+    random_vu_reg(&state->acc_h);
+    random_vu_reg(&state->acc_m);
+    random_vu_reg(&state->acc_l);
+    state->divin = random_element();
+    state->divin_loaded = rand() & 1;
+    state->divout = random_element();
+    for (int i = 0; i < SP_DMEM_SIZE; i++) {
+        state->dmem[i] = rand();
+    }
+}
+
+mips_instruction_t random_instruction() {
+    mips_instruction_t instr;
+    u32 vt = rand() & 31;
+    u32 vs = rand() & 31;
+    u32 vd = rand() & 31;
+    u32 e = rand() & 15;
+    int kind = rand() % 8;
+    if (kind < 5) {
+        // Every funct decodes to something, the undocumented ones included
+        instr.raw = OPC_CP2 << 26 | 1 << 25 | e << 21 | vt << 16 | vs << 11 | vd << 6 | (rand() & 63);
+    } else if (kind < 7) {
+        u32 opc = kind == 5 ? RSP_OPC_LWC2 : RSP_OPC_SWC2;
+        u32 funct = load_store_functs[rand() % NUM_LOAD_STORE_FUNCTS];
+        u32 base = rand() & 31;
+        instr.raw = opc << 26 | base << 21 | vt << 16 | funct << 11 | e << 7 | (rand() & 0x7F);
+    } else {
+        u32 funct = regmove_functs[rand() % 4];
+        u32 rt = rand() & 31;
+        // Only vco, vcc and vce for the control registers
+        u32 rd = (funct == COP_CF || funct == COP_CT) ? rand() % 3 : vd;
+        instr.raw = OPC_CP2 << 26 | funct << 21 | rt << 16 | rd << 11 | e << 7;
+    }
+    return instr;
+}
+
+void load_state(const vu_state_t* state) {
+    memcpy(N64RSP.gpr, state->gpr, sizeof(state->gpr));
+    memcpy(N64RSP.vu_regs, state->vu_regs, sizeof(state->vu_regs));
+    N64RSP.vcc.l = state->vcc_l;
+    N64RSP.vcc.h = state->vcc_h;
+    N64RSP.vco.l = state->vco_l;
+    N64RSP.vco.h = state->vco_h;
+    N64RSP.vce = state->vce;
+    N64RSP.acc.h = state->acc_h;
+    N64RSP.acc.m = state->acc_m;
+    N64RSP.acc.l = state->acc_l;
+    N64RSP.divin = state->divin;
+    N64RSP.divin_loaded = state->divin_loaded;
+    N64RSP.divout = state->divout;
+    memcpy(N64RSP.sp_dmem, state->dmem, SP_DMEM_SIZE);
+}
+
+void save_state(vu_state_t* state) {
+    memset(state, 0, sizeof(vu_state_t));
+    memcpy(state->gpr, N64RSP.gpr, sizeof(state->gpr));
+    memcpy(state->vu_regs, N64RSP.vu_regs, sizeof(state->vu_regs));
+    state->vcc_l = N64RSP.vcc.l;
+    state->vcc_h = N64RSP.vcc.h;
+    state->vco_l = N64RSP.vco.l;
+    state->vco_h = N64RSP.vco.h;
+    state->vce = N64RSP.vce;
+    state->acc_h = N64RSP.acc.h;
+    state->acc_m = N64RSP.acc.m;
+    state->acc_l = N64RSP.acc.l;
+    state->divin = N64RSP.divin;
+    state->divin_loaded = N64RSP.divin_loaded;
+    state->divout = N64RSP.divout;
+    memcpy(state->dmem, N64RSP.sp_dmem, SP_DMEM_SIZE);
+}
+
+// The instruction, then a break to end the block
+void load_program(mips_instruction_t instr) {
+    word_to_byte_array(N64RSP.sp_imem, 0, instr.raw);
+    word_to_byte_array(N64RSP.sp_imem, 4, FUNCT_BREAK);
+    invalidate_rsp_icache(0);
+    invalidate_rsp_icache(4);
+    N64RSP.pc = 0;
+    N64RSP.next_pc = 1;
+    N64RSP.status.halt = false;
+    N64RSP.status.broke = false;
+}
+
+void run_interpreter(const vu_state_t* before, mips_instruction_t instr, rsp_vu_kernel_set_t set, vu_state_t* after) {
+    rsp_vu_use_kernels(set);
+    load_state(before);
+    load_program(instr);
+    rsp_step();
+    save_state(after);
+}
+
+void run_dynarec(const vu_state_t* before, mips_instruction_t instr, vu_state_t* after) {
+    // Anything the dynarec doesn't emit inline calls whichever kernels were in use when it was compiled
+    rsp_vu_use_kernels(RSP_VU_KERNELS_SCALAR);
+    load_state(before);
+    load_program(instr);
+    N64RSP.steps = 2;
+    rsp_dynarec_run();
+    if (!N64RSP.status.halt) {
+        logfatal("The dynarec didn't reach the break after 0x%08X", instr.raw);
+    }
+    save_state(after);
+}
+
+void print_reg_diff(const char* name, const vu_reg_t* expected, const vu_reg_t* actual) {
+    if (memcmp(expected, actual, sizeof(vu_reg_t)) == 0) {
+        return;
+    }
+    printf("    %-6s expected:", name);
+    for (int e = 0; e < 8; e++) {
+        printf(" %04X", expected->elements[e]);
+    }
+    printf("\n    %-6s actual:  ", name);
+    for (int e = 0; e < 8; e++) {
+        if (expected->elements[e] != actual->elements[e]) {
+            printf(" " COLOR_RED "%04X" COLOR_END, actual->elements[e]);
+        } else {
+            printf(" %04X", actual->elements[e]);
+        }
+    }
+    printf("\n");
+}
+
+// Returns true if they match
+bool compare_states(const char* implementation, mips_instruction_t instr, const vu_state_t* expected, const vu_state_t* actual) {
+    if (memcmp(expected, actual, sizeof(vu_state_t)) == 0) {
+        return true;
+    }
+
+    char disassembly[50];
+    disassemble(0, instr.raw, disassembly, sizeof(disassembly));
+    printf("%s differs from %s on 0x%08X [%s]:\n", implementation, rsp_vu_kernel_set_name(RSP_VU_KERNELS_SCALAR), instr.raw, disassembly);
+
+    char name[8];
+    for (int i = 0; i < 32; i++) {
+        snprintf(name, sizeof(name), "$v%d", i);
+        print_reg_diff(name, &expected->vu_regs[i], &actual->vu_regs[i]);
+    }
+    print_reg_diff("vcc.l", &expected->vcc_l, &actual->vcc_l);
+    print_reg_diff("vcc.h", &expected->vcc_h, &actual->vcc_h);
+    print_reg_diff("vco.l", &expected->vco_l, &actual->vco_l);
+    print_reg_diff("vco.h", &expected->vco_h, &actual->vco_h);
+    print_reg_diff("vce", &expected->vce, &actual->vce);
+    print_reg_diff("acc.h", &expected->acc_h, &actual->acc_h);
+    print_reg_diff("acc.m", &expected->acc_m, &actual->acc_m);
+    print_reg_diff("acc.l", &expected->acc_l, &actual->acc_l);
+    for (int i = 0; i < 32; i++) {
+        if (expected->gpr[i] != actual->gpr[i]) {
+            printf("    $%d expected: %08X actual: %08X\n", i, expected->gpr[i], actual->gpr[i]);
+        }
+    }
+    if (expected->divin != actual->divin || expected->divin_loaded != actual->divin_loaded || expected->divout != actual->divout) {
+        printf("    divin/loaded/divout expected: %04X/%d/%04X actual: %04X/%d/%04X\n",
+               (u16)expected->divin, expected->divin_loaded, (u16)expected->divout,
+               (u16)actual->divin, actual->divin_loaded, (u16)actual->divout);
+    }
+    for (int i = 0; i < SP_DMEM_SIZE; i++) {
+        if (expected->dmem[i] != actual->dmem[i]) {
+            printf("    DMEM[0x%03X] expected: %02X actual: %02X\n", i ^ 3, expected->dmem[i], actual->dmem[i]);
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    cflags_t* flags = cflags_init();
+    cflags_flag_t * verbose = cflags_add_bool(flags, 'v', "verbose", NULL, "enables verbose output, repeat up to 4 times for more verbosity");
+
+    int iterations = 100000;
+    cflags_add_int(flags, 'n', "iterations", &iterations, "number of random instructions to try");
+
+    int seed = 0;
+    cflags_add_int(flags, 's', "seed", &seed, "seed for the random instructions and states, picked from the time if not given");
+
+    bool keep_going = false;
+    cflags_add_bool(flags, 'k', "keep-going", &keep_going, "carry on after a mismatch, rather than stopping at the first");
+
+    bool help = false;
+    cflags_add_bool(flags, 'h', "help", &help, "Display this help message");
+
+    cflags_parse(flags, argc, argv);
+
+    if (help || flags->argc != 0 || iterations < 1) {
+        usage(flags);
+        return help ? 0 : 1;
+    }
+
+    log_set_verbosity(verbose->count);
+
+    if (seed == 0) {
+        seed = time(NULL);
+    }
+    srand(seed);
+    logalways("Seed: %d", seed);
+
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+
+    static vu_state_t before, expected, actual;
+    int mismatches = 0;
+    for (int i = 0; i < iterations && (keep_going || mismatches == 0); i++) {
+        random_state(&before);
+        mips_instruction_t instr = random_instruction();
+
+        run_interpreter(&before, instr, RSP_VU_KERNELS_SCALAR, &expected);
+
+        for (int set = RSP_VU_KERNELS_SCALAR + 1; set < RSP_VU_NUM_KERNEL_SETS; set++) {
+            if (rsp_vu_kernels_supported(set)) {
+                run_interpreter(&before, instr, set, &actual);
+                mismatches += !compare_states(rsp_vu_kernel_set_name(set), instr, &expected, &actual);
+            }
+        }
+
+        run_dynarec(&before, instr, &actual);
+        mismatches += !compare_states("dynarec", instr, &expected, &actual);
+    }
+
+    for (int set = RSP_VU_KERNELS_SCALAR + 1; set < RSP_VU_NUM_KERNEL_SETS; set++) {
+        if (!rsp_vu_kernels_supported(set)) {
+            logalways("This CPU can't run the %s kernels, so they weren't checked", rsp_vu_kernel_set_name(set));
+        }
+    }
+
+    if (mismatches > 0) {
+        logalways("%d mismatches, rerun with --seed %d to see them again", mismatches, seed);
+        return 1;
+    }
+    logalways("No mismatches in %d instructions", iterations);
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <cflags.h>
+#include <log.h>
+#include <system/n64system.h>
+#include <mem/n64bus.h>
+#include <cpu/dynarec/dynarec.h>
+#include <cpu/dynarec/dynarec_warm.h>
+
+// IPL3 copies this much of the ROM, starting after the header and boot code, to the entry point.
+#define BOOT_SEGMENT_ROM_OFFSET 0x1000
+#define BOOT_SEGMENT_SIZE 0x100000
+
+void usage(cflags_t* flags) {
+    cflags_print_usage(flags,
+                       "[OPTION]... FILE",
+                       "Finds the code reachable from a ROM's entry point and lists its blocks for --warm-blocks",
+                       "https://github.com/Dillonb/n64");
+}
+
+static u32 boot_segment_start;
+static u32 boot_segment_end;
+
+static u64* worklist;
+static int worklist_size;
+static bool* visited; // One per word of RDRAM
+
+static dynarec_warm_block_t* blocks;
+static u32 num_blocks;
+
+u32 entry_point(n64_rom_t* rom) {
+    // Same adjustments IPL3 makes for these CICs
+    switch (rom->cic_type) {
+        case CIC_NUS_6103_7103:
+            return rom->header.program_counter - 0x100000;
+        case CIC_NUS_6106_7106:
+            return rom->header.program_counter - 0x200000;
+        default:
+            return rom->header.program_counter;
+    }
+}
+
+void load_boot_segment(n64_rom_t* rom, u32 entry) {
+    u32 size = BOOT_SEGMENT_SIZE;
+    if (rom->size < BOOT_SEGMENT_ROM_OFFSET + size) {
+        size = rom->size - BOOT_SEGMENT_ROM_OFFSET;
+    }
+    boot_segment_start = entry & 0x1FFFFFFF;
+    boot_segment_end = boot_segment_start + size;
+    if (boot_segment_end > N64_RDRAM_SIZE) {
+        boot_segment_end = N64_RDRAM_SIZE;
+    }
+
+    for (u32 offset = 0; boot_segment_start + offset < boot_segment_end; offset += 4) {
+        u32 word = n64_read_physical_word(SREGION_CART_1_2 + BOOT_SEGMENT_ROM_OFFSET + offset);
+        n64_write_physical_word(boot_segment_start + offset, word);
+    }
+}
+
+// Only follow code in the boot segment through KSEG0/KSEG1. Everything else isn't loaded yet, or is TLB mapped.
+void discover(u64 virtual_address) {
+    if (se_32_64(virtual_address) != virtual_address || ((u32)virtual_address >> 30) != 0b10 || (virtual_address & 3) != 0) {
+        return;
+    }
+    u32 physical = (u32)virtual_address & 0x1FFFFFFF;
+    if (physical < boot_segment_start || physical >= boot_segment_end || visited[physical >> 2]) {
+        return;
+    }
+    visited[physical >> 2] = true;
+    worklist[worklist_size++] = virtual_address;
+}
+
+// Queues up the targets of the branch or jump at address, if it is one
+void discover_targets(mips_instruction_t instr, u64 address) {
+    s16 offset = instr.i.immediate;
+    u64 branch_target = address + 4 + ((s64)offset << 2);
+    switch (instr.op) {
+        case OPC_J:
+        case OPC_JAL:
+            discover(((address + 4) & ~0x0FFFFFFFULL) | (instr.j.target << 2));
+            break;
+        case OPC_BEQ:
+        case OPC_BEQL:
+        case OPC_BNE:
+        case OPC_BNEL:
+        case OPC_BLEZ:
+        case OPC_BLEZL:
+        case OPC_BGTZ:
+        case OPC_BGTZL:
+        case OPC_REGIMM:
+            discover(branch_target);
+            break;
+        case OPC_CP1:
+            if (instr.r.rs == COP_BC) {
+                discover(branch_target);
+            }
+            break;
+    }
+}
+
+// Execution never continues in a straight line past these (or past their delay slot)
+bool ends_straight_line(mips_instruction_t instr) {
+    return instr.op == OPC_J
+        || (instr.op == OPC_SPCL && instr.r.funct == FUNCT_JR)
+        || (instr.op == OPC_CP0 && instr.r.funct == COP_FUNCT_ERET);
+}
+
+void compile_reachable(u64 virtual_address) {
+    u32 physical = (u32)virtual_address & 0x1FFFFFFF;
+    u32 length = n64_dynarec_compile_block(virtual_address, physical);
+
+    dynarec_warm_block_t* block = &blocks[num_blocks++];
+    block->virtual_address = virtual_address;
+    block->physical_address = physical;
+    block->guest_length = length;
+    block->guest_hash = dynarec_warm_guest_hash(physical, length);
+    block->reserved = 0;
+
+    bool falls_through = true;
+    for (u32 i = 0; i < length; i++) {
+        mips_instruction_t instr;
+        instr.raw = n64_read_physical_word(physical + i * 4);
+        discover_targets(instr, virtual_address + i * 4);
+        // Blocks end on the delay slot of a branch, or on an ERET
+        if (i + 2 >= length && ends_straight_line(instr)) {
+            falls_through = false;
+        }
+    }
+
+    // Straight after a branch's delay slot is where the not taken path and the return from a call go
+    if (falls_through) {
+        discover(virtual_address + length * 4);
+    }
+}
+
+int main(int argc, char** argv) {
+    cflags_t* flags = cflags_init();
+    cflags_flag_t * verbose = cflags_add_bool(flags, 'v', "verbose", NULL, "enables verbose output, repeat up to 4 times for more verbosity");
+
+    const char* output_path = NULL;
+    cflags_add_string(flags, 'o', "output", &output_path, "Warm block list file to write");
+
+    cflags_parse(flags, argc, argv);
+
+    if (flags->argc != 1 || output_path == NULL) {
+        usage(flags);
+        return 1;
+    }
+
+    log_set_verbosity(verbose->count);
+
+    init_n64system(flags->argv[0], false, false, UNKNOWN_VIDEO_TYPE, false);
+    n64_rom_t* rom = &n64sys.mem.rom;
+    if (rom->rom == NULL) {
+        logdie("Unable to load ROM %s", flags->argv[0]);
+    }
+
+    u32 entry = entry_point(rom);
+    load_boot_segment(rom, entry);
+
+    u32 max_blocks = (boot_segment_end - boot_segment_start) >> 2;
+    worklist = malloc(max_blocks * sizeof(u64));
+    visited = calloc(N64_RDRAM_SIZE >> 2, sizeof(bool));
+    blocks = malloc(max_blocks * sizeof(dynarec_warm_block_t));
+
+    discover(se_32_64(entry));
+    while (worklist_size > 0) {
+        compile_reachable(worklist[--worklist_size]);
+    }
+
+    logalways("Found %u blocks reachable from entry point 0x%08X", num_blocks, entry);
+    if (!dynarec_warm_write(output_path, rom, blocks, num_blocks)) {
+        logdie("Failed to write %s", output_path);
+    }
+
+    free(worklist);
+    free(visited);
+    free(blocks);
+    cflags_free(flags);
+    return 0;
+}
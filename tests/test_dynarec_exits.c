@@ -0,0 +1,70 @@
+#include <system/n64system.h>
+#include <cpu/dynarec/dynarec.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+#define BLOCK_VIRTUAL  0xFFFFFFFF80001000
+#define CALL_TARGET    0x80002000
+
+#define I_TYPE(op, rs, rt, immediate) ((op) << 26 | (rs) << 21 | (rt) << 16 | (u16)(immediate))
+#define J_TYPE(op, target) ((op) << 26 | (((target) >> 2) & 0x3FFFFFF))
+
+void write_rdram_word(u64 virtual, u32 value) {
+    word_to_byte_array(n64sys.mem.rdram, (u32)virtual & 0x1FFFFFFF, value);
+}
+
+/*
+ * A superblock that compiles through a forward bne with a side exit, and ends in a call:
+ *   bne $1, $0, skip
+ *   nop
+ *   jal CALL_TARGET
+ *   nop
+ *   ...
+ * skip:
+ */
+void upload_block() {
+    write_rdram_word(BLOCK_VIRTUAL + 0x00, I_TYPE(OPC_BNE, 1, 0, 7));
+    write_rdram_word(BLOCK_VIRTUAL + 0x04, 0);
+    write_rdram_word(BLOCK_VIRTUAL + 0x08, J_TYPE(OPC_JAL, CALL_TARGET));
+    write_rdram_word(BLOCK_VIRTUAL + 0x0C, 0);
+    for (int i = 0x10; i <= 0x20; i += 4) {
+        write_rdram_word(BLOCK_VIRTUAL + i, 0);
+    }
+}
+
+void run_block(u64 r1) {
+    N64CPU.gpr[1] = r1;
+    N64CPU.pc = BLOCK_VIRTUAL;
+    N64CPU.next_pc = BLOCK_VIRTUAL + 4;
+    N64CPU.branch = false;
+    n64_dynarec_step();
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    upload_block();
+
+    // Leaving through the side exit isn't a call, so nothing gets pushed
+    dynarec_reset_block_links(N64DYNAREC);
+    run_block(1);
+    ASSERT_INT_EQUALS("side exit goes to the branch target", BLOCK_VIRTUAL + 0x20, N64CPU.pc);
+    ASSERT_INT_EQUALS("side exit leaves the return address stack alone", 0, N64DYNAREC->return_address_stack_top);
+    ASSERT_TRUE("side exit isn't predicted from", N64DYNAREC->last_exit == NULL);
+
+    // Running through to the call at the end still pushes its return address
+    run_block(0);
+    ASSERT_INT_EQUALS("call goes to its target", se_32_64(CALL_TARGET), N64CPU.pc);
+    ASSERT_INT_EQUALS("call pushes a return address", 1, N64DYNAREC->return_address_stack_top);
+    ASSERT_TRUE("call is predicted from", N64DYNAREC->last_exit != NULL);
+    ASSERT_INT_EQUALS("call exit type", BLOCK_EXIT_CALL, N64DYNAREC->last_exit->type);
+    ASSERT_INT_EQUALS("call return address", BLOCK_VIRTUAL + 0x10, N64DYNAREC->last_exit->return_address);
+
+    // The side exit again, now that the block is compiled, doesn't move the stack either
+    run_block(1);
+    ASSERT_INT_EQUALS("compiled side exit goes to the branch target", BLOCK_VIRTUAL + 0x20, N64CPU.pc);
+    ASSERT_INT_EQUALS("compiled side exit leaves the return address stack alone", 1, N64DYNAREC->return_address_stack_top);
+    ASSERT_TRUE("compiled side exit isn't predicted from", N64DYNAREC->last_exit == NULL);
+
+    printf("Passed!\n");
+}
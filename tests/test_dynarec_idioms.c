@@ -0,0 +1,104 @@
+#include <system/n64system.h>
+#include <cpu/dynarec/dynarec_idioms.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+#define LOOP_PHYSICAL 0x1000
+#define LOOP_VIRTUAL  0xFFFFFFFF80001000
+#define DATA_VIRTUAL  0xFFFFFFFF80002000
+#define COPY_VIRTUAL  0xFFFFFFFF80003000
+
+#define I_TYPE(op, rs, rt, immediate) ((op) << 26 | (rs) << 21 | (rt) << 16 | (u16)(immediate))
+
+u32 read_rdram_word(u64 virtual) {
+    return word_from_byte_array(n64sys.mem.rdram, (u32)virtual & 0x1FFFFFFF);
+}
+
+void write_rdram_word(u64 virtual, u32 value) {
+    word_to_byte_array(n64sys.mem.rdram, (u32)virtual & 0x1FFFFFFF, value);
+}
+
+void fill_rdram(u64 virtual, int words, u32 value) {
+    for (int i = 0; i < words; i++) {
+        write_rdram_word(virtual + i * 4, value);
+    }
+}
+
+void detect_idiom(dynarec_idiom_t* idiom) {
+    ASSERT_TRUE("loop detected", detect_loop_idiom(LOOP_PHYSICAL, idiom));
+}
+
+void test_word_fill() {
+    write_rdram_word(LOOP_VIRTUAL + 0, I_TYPE(OPC_ADDIU, 4, 4, 4)); // addiu $4, $4, 4
+    write_rdram_word(LOOP_VIRTUAL + 4, I_TYPE(OPC_BNE, 4, 5, -2));  // bne   $4, $5, loop
+    write_rdram_word(LOOP_VIRTUAL + 8, I_TYPE(OPC_SW, 4, 6, -4));   // sw    $6, -4($4)
+    dynarec_idiom_t idiom;
+    detect_idiom(&idiom);
+
+    fill_rdram(DATA_VIRTUAL, 0x20, 0);
+    N64CPU.gpr[4] = DATA_VIRTUAL;
+    N64CPU.gpr[5] = DATA_VIRTUAL + 0x40;
+    N64CPU.gpr[6] = 0xDEADBEEF;
+    ASSERT_INT_EQUALS("fill instructions run", 16 * 3, idiom.handler(idiom.regs, LOOP_VIRTUAL));
+    ASSERT_INT_EQUALS("fill first word", 0xDEADBEEF, read_rdram_word(DATA_VIRTUAL));
+    ASSERT_INT_EQUALS("fill last word", 0xDEADBEEF, read_rdram_word(DATA_VIRTUAL + 0x3C));
+    ASSERT_INT_EQUALS("fill stops at the end", 0, read_rdram_word(DATA_VIRTUAL + 0x40));
+    ASSERT_INT_EQUALS("fill pointer at the end", DATA_VIRTUAL + 0x40, N64CPU.gpr[4]);
+    ASSERT_INT_EQUALS("fill falls out of the loop", LOOP_VIRTUAL + 12, N64CPU.pc);
+
+    // The real loop's first store raises an address error, so it has to run for real
+    fill_rdram(DATA_VIRTUAL, 0x20, 0);
+    N64CPU.gpr[4] = DATA_VIRTUAL + 2;
+    N64CPU.gpr[5] = DATA_VIRTUAL + 0x42;
+    ASSERT_INT_EQUALS("misaligned fill left to the real loop", 0, idiom.handler(idiom.regs, LOOP_VIRTUAL));
+    ASSERT_INT_EQUALS("misaligned fill wrote nothing", 0, read_rdram_word(DATA_VIRTUAL));
+    ASSERT_INT_EQUALS("misaligned fill pointer untouched", DATA_VIRTUAL + 2, N64CPU.gpr[4]);
+}
+
+void test_word_copy() {
+    write_rdram_word(LOOP_VIRTUAL + 0,  I_TYPE(OPC_LW, 4, 7, 0));     // lw    $7, 0($4)
+    write_rdram_word(LOOP_VIRTUAL + 4,  I_TYPE(OPC_ADDIU, 4, 4, 4));  // addiu $4, $4, 4
+    write_rdram_word(LOOP_VIRTUAL + 8,  I_TYPE(OPC_ADDIU, 8, 8, 4));  // addiu $8, $8, 4
+    write_rdram_word(LOOP_VIRTUAL + 12, I_TYPE(OPC_BNE, 4, 5, -4));   // bne   $4, $5, loop
+    write_rdram_word(LOOP_VIRTUAL + 16, I_TYPE(OPC_SW, 8, 7, -4));    // sw    $7, -4($8)
+    dynarec_idiom_t idiom;
+    detect_idiom(&idiom);
+
+    for (int i = 0; i < 0x10; i++) {
+        write_rdram_word(DATA_VIRTUAL + i * 4, 0x1000 + i);
+    }
+    fill_rdram(COPY_VIRTUAL, 0x20, 0);
+    N64CPU.gpr[4] = DATA_VIRTUAL;
+    N64CPU.gpr[5] = DATA_VIRTUAL + 0x40;
+    N64CPU.gpr[8] = COPY_VIRTUAL;
+    ASSERT_INT_EQUALS("copy instructions run", 16 * 5, idiom.handler(idiom.regs, LOOP_VIRTUAL));
+    ASSERT_INT_EQUALS("copy first word", 0x1000, read_rdram_word(COPY_VIRTUAL));
+    ASSERT_INT_EQUALS("copy last word", 0x100F, read_rdram_word(COPY_VIRTUAL + 0x3C));
+    ASSERT_INT_EQUALS("copy stops at the end", 0, read_rdram_word(COPY_VIRTUAL + 0x40));
+    ASSERT_INT_EQUALS("copy temporary holds the last word", 0x100F, N64CPU.gpr[7]);
+    ASSERT_INT_EQUALS("copy destination at the end", COPY_VIRTUAL + 0x40, N64CPU.gpr[8]);
+
+    // Either pointer being misaligned makes the real loop raise an address error
+    fill_rdram(COPY_VIRTUAL, 0x20, 0);
+    N64CPU.gpr[4] = DATA_VIRTUAL + 1;
+    N64CPU.gpr[5] = DATA_VIRTUAL + 0x41;
+    N64CPU.gpr[8] = COPY_VIRTUAL;
+    ASSERT_INT_EQUALS("misaligned source left to the real loop", 0, idiom.handler(idiom.regs, LOOP_VIRTUAL));
+    N64CPU.gpr[4] = DATA_VIRTUAL;
+    N64CPU.gpr[5] = DATA_VIRTUAL + 0x40;
+    N64CPU.gpr[8] = COPY_VIRTUAL + 2;
+    ASSERT_INT_EQUALS("misaligned destination left to the real loop", 0, idiom.handler(idiom.regs, LOOP_VIRTUAL));
+    ASSERT_INT_EQUALS("misaligned copy wrote nothing", 0, read_rdram_word(COPY_VIRTUAL));
+    ASSERT_INT_EQUALS("misaligned copy wrote nothing", 0, read_rdram_word(COPY_VIRTUAL + 4));
+    ASSERT_INT_EQUALS("misaligned destination untouched", COPY_VIRTUAL + 2, N64CPU.gpr[8]);
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    N64CP0.kernel_mode = true;
+
+    test_word_fill();
+    test_word_copy();
+    printf("Passed!\n");
+}
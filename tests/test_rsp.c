@@ -8,6 +8,7 @@
 #include <bzlib.h>
 #include <system/n64system.h>
 #include <cpu/rsp.h>
+#include <cpu/rsp_vector_instructions.h>
 #include <mem/mem_util.h>
 #include <cpu/n64_rsp_bus.h>
 
@@ -110,6 +111,16 @@ bool run_test(u32* input, int input_size, u32* output, int output_size) {
 void load_test(const char* rsp_path) {
     init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
     load_rsp_imem(rsp_path);
+    // A reset leaves the registers alone, and tests that accumulate expect to start from zero every time they're run
+    memset(N64RSP.gpr, 0, sizeof(N64RSP.gpr));
+    memset(N64RSP.vu_regs, 0, sizeof(N64RSP.vu_regs));
+    memset(&N64RSP.acc, 0, sizeof(N64RSP.acc));
+    memset(&N64RSP.vcc, 0, sizeof(N64RSP.vcc));
+    memset(&N64RSP.vco, 0, sizeof(N64RSP.vco));
+    memset(&N64RSP.vce, 0, sizeof(N64RSP.vce));
+    N64RSP.divin = 0;
+    N64RSP.divin_loaded = false;
+    N64RSP.divout = 0;
 }
 
 int main(int argc, char** argv) {
@@ -146,26 +157,36 @@ int main(int argc, char** argv) {
     char rsp_path[PATH_MAX];
     snprintf(rsp_path, PATH_MAX, "%s.rsp", test_name);
 
-    load_test(rsp_path);
+    // Once with each set of vector unit kernels this CPU can run, not just the one that would be picked for it
+    for (int set = 0; set < RSP_VU_NUM_KERNEL_SETS && !failed; set++) {
+        load_test(rsp_path);
+        if (!rsp_vu_kernels_supported(set)) {
+            printf("[%s] %s kernels not supported on this CPU, skipping\n", test_name, rsp_vu_kernel_set_name(set));
+            continue;
+        }
+        rsp_vu_use_kernels(set);
+        rewind(input_data_handle);
+        rewind(output_data_handle);
 
-    for (int i = 4; i < argc; i++) {
-        const char* subtest_name = argv[i];
-        u8 input[input_size];
-        fread(input, 1, input_size, input_data_handle);
-        u8 output[output_size];
-        fread(output, 1, output_size, output_data_handle);
+        for (int i = 4; i < argc; i++) {
+            const char* subtest_name = argv[i];
+            u8 input[input_size];
+            fread(input, 1, input_size, input_data_handle);
+            u8 output[output_size];
+            fread(output, 1, output_size, output_data_handle);
 
-        bool subtest_failed = run_test((u32 *) input, input_size, (u32 *) output, output_size);
+            bool subtest_failed = run_test((u32 *) input, input_size, (u32 *) output, output_size);
 
-        if (subtest_failed) {
-            printf("[%s %s] FAILED\n", test_name, subtest_name);
-        } else {
-            printf("[%s %s] PASSED\n", test_name, subtest_name);
-        }
+            if (subtest_failed) {
+                printf("[%s %s %s] FAILED\n", test_name, subtest_name, rsp_vu_kernel_set_name(set));
+            } else {
+                printf("[%s %s %s] PASSED\n", test_name, subtest_name, rsp_vu_kernel_set_name(set));
+            }
 
-        failed |= subtest_failed;
-        if (failed) {
-            break;
+            failed |= subtest_failed;
+            if (failed) {
+                break;
+            }
         }
     }
 
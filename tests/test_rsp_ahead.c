@@ -0,0 +1,63 @@
+#include <system/n64system.h>
+#include <system/scheduler.h>
+#include <system/rsp_ahead.h>
+#include <cpu/rsp.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+// Instructions in the task, counting the break
+#define TASK_LENGTH 20
+
+// Stores 0x1234 to DMEM 0, then runs out its length in nops and breaks
+void upload_task() {
+    word_to_byte_array(N64RSP.sp_imem, 0, OPC_ADDIU << 26 | 1 << 16 | 0x1234); // addiu $1, $0, 0x1234
+    word_to_byte_array(N64RSP.sp_imem, 4, OPC_SW << 26 | 1 << 16); // sw $1, 0($0)
+    for (int i = 2; i < TASK_LENGTH - 1; i++) {
+        word_to_byte_array(N64RSP.sp_imem, i * 4, 0); // nop
+    }
+    word_to_byte_array(N64RSP.sp_imem, (TASK_LENGTH - 1) * 4, FUNCT_BREAK);
+    invalidate_rsp_icache_range(0, TASK_LENGTH * 4);
+}
+
+// Runs the system's scheduler for this many cycles, without the CPU
+void run_cycles(u64 cycles) {
+    scheduler_event_t event;
+    for (u64 i = 0; i < cycles; i++) {
+        if (scheduler_tick(1, &event)) {
+            handle_scheduler_event(&event);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    n64sys.rsp_run_ahead = true;
+
+    upload_task();
+    word_to_byte_array(N64RSP.sp_dmem, 0, 0);
+    N64RSP.pc = 0;
+    N64RSP.next_pc = 1;
+    N64RSP.status.intr_on_break = true;
+    N64RSP.status.halt = false;
+    n64sys.mi.intr.sp = false;
+
+    // The whole task runs right away, but the CPU sees it take 3 CPU cycles for every 2 RSP steps
+    u64 start = scheduler_ticks;
+    u64 end_time = start + TASK_LENGTH * 3 / 2;
+    rsp_ahead_step(1, false);
+    ASSERT_INT_EQUALS("task held back", true, rsp_ahead_pending);
+
+    run_cycles(end_time - scheduler_ticks);
+    ASSERT_INT_EQUALS("no interrupt before the task would have broken", false, n64sys.mi.intr.sp);
+    ASSERT_INT_EQUALS("still running before the task would have broken", false, N64RSP.status.halt);
+    ASSERT_INT_EQUALS("DMEM as it was before the task would have broken", 0, word_from_byte_array(N64RSP.sp_dmem, 0));
+
+    run_cycles(1);
+    ASSERT_INT_EQUALS("interrupt once the task would have broken", true, n64sys.mi.intr.sp);
+    ASSERT_INT_EQUALS("halted once the task would have broken", true, N64RSP.status.halt);
+    ASSERT_INT_EQUALS("DMEM written once the task would have broken", 0x1234, word_from_byte_array(N64RSP.sp_dmem, 0));
+    ASSERT_INT_EQUALS("nothing held back after the task", false, rsp_ahead_pending);
+
+    printf("Passed!\n");
+}
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <string.h>
+#include <system/n64system.h>
+#include <cpu/rsp.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+// Checks RSP DMAs against a byte at a time copy, across the 4KiB SP memory wrap, past the end of RDRAM, with skips
+// between rows, and that IMEM's cached instructions are refreshed for everything a DMA overwrites.
+
+typedef struct dma_case {
+    const char* name;
+    bool read; // RDRAM to SP memory
+    bool imem;
+    u32 mem_address;
+    u32 dram_address;
+    u32 length; // Bytes per row, a multiple of 8
+    u32 count; // Rows - 1
+    u32 skip;
+} dma_case_t;
+
+static const dma_case_t cases[] = {
+        { "read across the wrap",           true,  false, 0xFF0, 0x001000, 0x40,  2, 0x10 },
+        { "write across the wrap",          false, false, 0xFE8, 0x002008, 0x30,  3, 0x08 },
+        { "read past the end of RDRAM",     true,  false, 0x100, N64_RDRAM_SIZE - 0x18, 0x40, 1, 0 },
+        { "write past the end of RDRAM",    false, false, 0x100, N64_RDRAM_SIZE - 0x18, 0x40, 1, 0 },
+        { "IMEM read across the wrap",      true,  true,  0xFC0, 0x003000, 0x80,  1, 0x40 },
+        { "IMEM read longer than IMEM",     true,  true,  0x400, 0x004000, 0x800, 2, 0 },
+        { "IMEM write across the wrap",     false, true,  0xFF8, 0x005000, 0x18,  4, 0x100 },
+};
+
+static u8 expected_rdram[N64_RDRAM_SIZE];
+static u8 expected_mem[SP_DMEM_SIZE];
+
+// The original byte loop, except that what's past the end of RDRAM reads as 0 and can't be written
+void reference_dma(const dma_case_t* c, u32* final_mem_address, u32* final_dram_address) {
+    u32 mem_address = c->mem_address;
+    u32 dram_address = c->dram_address;
+    for (int i = 0; i <= c->count; i++) {
+        for (int j = 0; j < c->length; j++) {
+            u16 addr = (mem_address + j) & 0xFFF;
+            u32 dram = dram_address + j;
+            if (c->read) {
+                expected_mem[addr] = dram < N64_RDRAM_SIZE ? expected_rdram[dram] : 0;
+            } else if (dram < N64_RDRAM_SIZE) {
+                expected_rdram[dram] = expected_mem[addr];
+            }
+        }
+        int skip = i == c->count ? 0 : c->skip;
+        dram_address = (dram_address + c->length + skip) & RSP_DRAM_ADDR_MASK;
+        mem_address = (mem_address + c->length) & RSP_MEM_ADDR_MASK;
+    }
+    *final_mem_address = mem_address;
+    *final_dram_address = dram_address;
+}
+
+void randomize(u8* buf, int size) {
+    for (int i = 0; i < size; i++) {
+        buf[i] = rand();
+    }
+}
+
+void run_case(const dma_case_t* c) {
+    u8* mem = c->imem ? N64RSP.sp_imem : N64RSP.sp_dmem;
+    randomize(mem, SP_DMEM_SIZE);
+    randomize(n64sys.mem.rdram, 0x10000);
+    randomize(n64sys.mem.rdram + N64_RDRAM_SIZE - 0x10000, 0x10000);
+    if (c->imem) {
+        invalidate_rsp_icache_range(0, SP_IMEM_SIZE);
+    }
+    memcpy(expected_mem, mem, SP_DMEM_SIZE);
+    memcpy(expected_rdram, n64sys.mem.rdram, N64_RDRAM_SIZE);
+
+    u32 expected_mem_address, expected_dram_address;
+    reference_dma(c, &expected_mem_address, &expected_dram_address);
+
+    N64RSP.io.shadow_mem_addr.raw = c->mem_address | (c->imem ? 0x1000 : 0);
+    N64RSP.io.shadow_dram_addr.raw = c->dram_address;
+    N64RSP.io.dma.raw = (c->length - 1) | c->count << 12 | c->skip << 20;
+    if (c->read) {
+        rsp_dma_read();
+    } else {
+        rsp_dma_write();
+    }
+
+    int failures = tests_failed;
+    if (memcmp(mem, expected_mem, SP_DMEM_SIZE) != 0) {
+        failed("[%s] %s differs", c->name, c->imem ? "IMEM" : "DMEM")
+    }
+    if (memcmp(n64sys.mem.rdram, expected_rdram, N64_RDRAM_SIZE) != 0) {
+        failed("[%s] RDRAM differs", c->name)
+    }
+    if (N64RSP.io.mem_addr.address != expected_mem_address || N64RSP.io.dram_addr.address != expected_dram_address) {
+        failed("[%s] ended at MEM 0x%03X DRAM 0x%06X, expected MEM 0x%03X DRAM 0x%06X", c->name,
+               N64RSP.io.mem_addr.address, N64RSP.io.dram_addr.address, expected_mem_address, expected_dram_address)
+    }
+    if (c->imem) {
+        for (int i = 0; i < SP_IMEM_SIZE / 4; i++) {
+            if (N64RSP.icache[i].instruction.raw != word_from_byte_array(N64RSP.sp_imem, i * 4)) {
+                failed("[%s] cached instruction at IMEM 0x%03X is stale", c->name, i * 4)
+                break;
+            }
+        }
+    }
+    if (failures == tests_failed) {
+        passed("[%s]", c->name)
+    }
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    srand(1);
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        run_case(&cases[i]);
+    }
+    exit(tests_failed > 0);
+}
@@ -0,0 +1,70 @@
+#include <system/n64system.h>
+#include <cpu/rsp.h>
+#include <cpu/dynarec/rsp_dynarec.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+// A microcode that sets $1 to its id and breaks. Every id gives a different IMEM image.
+void upload_image(u16 id) {
+    word_to_byte_array(N64RSP.sp_imem, 0, OPC_ADDIU << 26 | 1 << 16 | id); // addiu $1, $0, id
+    word_to_byte_array(N64RSP.sp_imem, 4, FUNCT_BREAK);
+    invalidate_rsp_icache_range(0, 8);
+}
+
+u32 run_image() {
+    N64RSP.gpr[1] = 0;
+    N64RSP.pc = 0;
+    N64RSP.next_pc = 1;
+    N64RSP.status.halt = false;
+    N64RSP.steps = 100;
+    rsp_dynarec_run();
+    ASSERT_TRUE("ran to the break", N64RSP.status.halt);
+    return N64RSP.gpr[1];
+}
+
+// Whether the block at IMEM 0 was already compiled for the image that's uploaded now
+bool image_compiled() {
+    rsp_dynarec_select_image();
+    return N64RSPDYNAREC->blockcache[0].run != rsp_missing_block_handler;
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+
+    // Switching between two microcodes keeps both compiled, and never runs the other one's code
+    upload_image(1);
+    ASSERT_INT_EQUALS("first image", 1, run_image());
+    upload_image(2);
+    ASSERT_TRUE("second image not compiled yet", !image_compiled());
+    ASSERT_INT_EQUALS("second image", 2, run_image());
+    for (int i = 0; i < 4; i++) {
+        upload_image(1);
+        ASSERT_TRUE("first image reused", image_compiled());
+        ASSERT_INT_EQUALS("first image again", 1, run_image());
+        upload_image(2);
+        ASSERT_TRUE("second image reused", image_compiled());
+        ASSERT_INT_EQUALS("second image again", 2, run_image());
+    }
+
+    // One more image than there's room for pushes out the one that's gone unused longest
+    for (int id = 3; id < 3 + RSP_NUM_UCODE_IMAGES - 1; id++) {
+        upload_image(id);
+        ASSERT_INT_EQUALS("filling the images", id, run_image());
+    }
+    upload_image(2);
+    ASSERT_TRUE("most recently used image kept", image_compiled());
+    ASSERT_INT_EQUALS("most recently used image", 2, run_image());
+    upload_image(1);
+    ASSERT_TRUE("least recently used image evicted", !image_compiled());
+    ASSERT_INT_EQUALS("evicted image recompiled", 1, run_image());
+
+    // Throwing everything away while the current image is still selected
+    rsp_dynarec_reset_images();
+    ASSERT_INT_EQUALS("current image after a reset", 1, run_image());
+    upload_image(2);
+    ASSERT_TRUE("other images gone after a reset", !image_compiled());
+    ASSERT_INT_EQUALS("other image after a reset", 2, run_image());
+
+    printf("Passed!\n");
+}
@@ -0,0 +1,174 @@
+#include <system/n64system.h>
+#include <cpu/rsp_hle.h>
+
+#include "unit.h"
+
+// The expected outputs below are worked through by hand, with the arithmetic the ABI1 microcode does on the RSP: Q15
+// products truncated and accumulated with a clamp after each, and ADPCM predicted in Q11.
+
+#define DMEM_BASE 0x5C0
+
+#define A_ADPCM     1
+#define A_RESAMPLE  5
+#define A_SETBUFF   8
+#define A_LOADADPCM 11
+#define A_MIXER     12
+
+#define A_INIT 0x01
+
+#define UCODE_DATA      0x100000
+#define UCODE_DATA_SIZE 0x800
+#define RESAMPLE_LUT    (UCODE_DATA + 0x240)
+#define COMMANDS        0x200000
+#define ADPCM_BOOK      0x201000
+#define ADPCM_STATE     0x202000
+#define RESAMPLE_STATE  0x203000
+
+static int num_commands = 0;
+
+void command(u32 w1, u32 w2) {
+    hle_rdram_write_u32(COMMANDS + num_commands * 8, w1);
+    hle_rdram_write_u32(COMMANDS + num_commands * 8 + 4, w2);
+    num_commands++;
+}
+
+void run_commands() {
+    rsp_hle_audio_abi1_run(UCODE_DATA, UCODE_DATA_SIZE, COMMANDS, num_commands * 8);
+    num_commands = 0;
+}
+
+void set_buffers(u16 in, u16 out, u16 count) {
+    command(A_SETBUFF << 24 | in, out << 16 | count);
+}
+
+s16 dmem_sample(u16 buffer, int i) {
+    return hle_dmem_s16(DMEM_BASE + buffer + i * 2);
+}
+
+void write_dmem_sample(u16 buffer, int i, s16 value) {
+    hle_dmem_write_s16(DMEM_BASE + buffer + i * 2, value);
+}
+
+// A linear interpolation table, in the microcode's data where it keeps its own
+void upload_resample_lut() {
+    for (u32 i = 0; i < UCODE_DATA_SIZE; i += 4) {
+        hle_rdram_write_u32(UCODE_DATA + i, 0);
+    }
+    for (int phase = 0; phase < 64; phase++) {
+        hle_rdram_write_s16(RESAMPLE_LUT + phase * 8 + 2, phase == 0 ? 0x7FFF : 0x8000 - phase * 0x200);
+        hle_rdram_write_s16(RESAMPLE_LUT + phase * 8 + 4, phase * 0x200);
+    }
+}
+
+void test_mixer() {
+    const u16 in = 0x000;
+    const u16 out = 0x100;
+    for (int i = 0; i < 16; i++) {
+        write_dmem_sample(in, i, 0x4000);
+        write_dmem_sample(out, i, 1000);
+    }
+    write_dmem_sample(in, 14, 0x7FFF);
+    write_dmem_sample(out, 14, 30000);
+    write_dmem_sample(in, 15, -0x8000);
+
+    set_buffers(0, 0, 32);
+    command(A_MIXER << 24 | 0x4000, in << 16 | out);
+    run_commands();
+    ASSERT_INT_EQUALS("mixer half gain", 1000 + 0x2000, dmem_sample(out, 0));
+    ASSERT_INT_EQUALS("mixer half gain, last of the first 8", 1000 + 0x2000, dmem_sample(out, 7));
+    ASSERT_INT_EQUALS("mixer half gain, first of the second 8", 1000 + 0x2000, dmem_sample(out, 8));
+    ASSERT_INT_EQUALS("mixer clamps", 0x7FFF, dmem_sample(out, 14));
+    ASSERT_INT_EQUALS("mixer negative", 1000 - 0x4000, dmem_sample(out, 15));
+
+    // -1.0 * -1.0 is clamped to just under 1.0 before it's added
+    write_dmem_sample(out, 15, -1);
+    command(A_MIXER << 24 | 0x8000, in << 16 | out);
+    run_commands();
+    ASSERT_INT_EQUALS("mixer -1.0 * -1.0", 0x7FFE, dmem_sample(out, 15));
+
+    // Buffers that aren't 16 byte aligned give the same result
+    for (int i = 0; i < 16; i++) {
+        write_dmem_sample(in + 2, i, 0x4000);
+        write_dmem_sample(out + 0x40 + 2, i, 1000);
+    }
+    command(A_MIXER << 24 | 0x4000, (in + 2) << 16 | (out + 0x40 + 2));
+    run_commands();
+    for (int i = 0; i < 16; i++) {
+        ASSERT_INT_EQUALS("misaligned mixer half gain", 1000 + 0x2000, dmem_sample(out + 0x40 + 2, i));
+    }
+}
+
+void test_adpcm() {
+    const u16 in = 0x200;
+    const u16 out = 0x300;
+
+    // Book 0: each sample adds the residual before it, the first of each 8 the last sample before them, and the second
+    // half of the one before that
+    for (int i = 0; i < 16; i++) {
+        hle_rdram_write_s16(ADPCM_BOOK + i * 2, 0);
+    }
+    hle_rdram_write_s16(ADPCM_BOOK + 1 * 2, 0x400); // book1[1], 0.5 in Q11
+    hle_rdram_write_s16(ADPCM_BOOK + 8 * 2, 0x800); // book2[0], 1.0 in Q11
+
+    // One frame: scale 0, book 0, then 16 4 bit residuals
+    const u8 frame[9] = { 0x00, 0x12, 0x34, 0x56, 0x70, 0xF0, 0xEF, 0x00, 0x00 };
+    for (int i = 0; i < 9; i++) {
+        n64rsp.sp_dmem[BYTE_ADDRESS(DMEM_BASE + in + i)] = frame[i];
+    }
+
+    command(A_LOADADPCM << 24 | 32, ADPCM_BOOK);
+    set_buffers(in, out, 32);
+    command(A_ADPCM << 24 | A_INIT << 16, ADPCM_STATE);
+    run_commands();
+
+    // The last frame comes first, all zero after A_INIT
+    for (int i = 0; i < 16; i++) {
+        ASSERT_INT_EQUALS("adpcm initial frame", 0, dmem_sample(out, i));
+    }
+    // First 8: nothing before them, so each is its residual plus the one before
+    const s16 expected[16] = {
+        1, 3, 5, 7, 9, 11, 13, 7,
+        // Second 8: the first adds 7, the second 13 / 2
+        6, 5, -2, -3, -1, 0, 0, 0
+    };
+    for (int i = 0; i < 16; i++) {
+        ASSERT_INT_EQUALS("adpcm decoded", expected[i], dmem_sample(out, 16 + i));
+        ASSERT_INT_EQUALS("adpcm state saved", expected[i], hle_rdram_s16(ADPCM_STATE + i * 2));
+    }
+}
+
+void test_resample() {
+    const u16 in = 0x400;
+    const u16 out = 0x500;
+    for (int i = 0; i < 16; i++) {
+        write_dmem_sample(in, i, 1000 * (i + 1));
+    }
+
+    // Half speed: every other sample is halfway between two input samples. The four samples before the input are
+    // zero after A_INIT, and the filter reads the second and third of its four taps.
+    set_buffers(in, out, 32);
+    command(A_RESAMPLE << 24 | A_INIT << 16 | 0x4000, RESAMPLE_STATE);
+    run_commands();
+
+    const s16 expected[16] = {
+        0, 0, 0, 0, 0, 500, 999, 1500, 1999, 2500, 2999, 3500, 3999, 4500, 4999, 5500
+    };
+    for (int i = 0; i < 16; i++) {
+        ASSERT_INT_EQUALS("resampled", expected[i], dmem_sample(out, i));
+    }
+    // The next call carries on from the four samples it's reached
+    for (int i = 0; i < 4; i++) {
+        ASSERT_INT_EQUALS("resample state samples", 1000 * (i + 5), hle_rdram_s16(RESAMPLE_STATE + i * 2));
+    }
+    ASSERT_INT_EQUALS("resample state pitch", 0, hle_rdram_s16(RESAMPLE_STATE + 8));
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    upload_resample_lut();
+
+    test_mixer();
+    test_adpcm();
+    test_resample();
+    printf("Passed!\n");
+}
@@ -0,0 +1,191 @@
+#include <system/n64system.h>
+#include <cpu/rsp_hle.h>
+
+#include "unit.h"
+
+#define DISPLAY_LIST 0x100000
+#define VERTICES     0x101000
+#define PROJECTION   0x102000
+#define NESTED_LISTS 0x110000
+
+// The limits in rsp_hle_gfx.c
+#define MAX_VERTICES  32
+#define DL_STACK_SIZE 18
+
+#define G_MTX           0x01
+#define G_VTX           0x04
+#define G_DL            0x06
+#define G_ENDDL         0xB8
+#define G_MOVEWORD      0xBC
+#define G_TRI1          0xBF
+#define G_SETPRIMCOLOR  0xFA
+#define G_SETCIMG       0xFF
+
+#define G_MTX_PROJECTION 0x01
+#define G_MTX_LOAD       0x02
+#define G_MW_SEGMENT     0x06
+
+// RDP commands the display list sent, in order
+#define MAX_RDP_COMMANDS 64
+static u32 rdp_commands[MAX_RDP_COMMANDS][22];
+static int rdp_command_lengths[MAX_RDP_COMMANDS];
+static int num_rdp_commands = 0;
+
+void record_rdp_command(int command_length, u32* buffer) {
+    ASSERT_TRUE("room for the RDP command", num_rdp_commands < MAX_RDP_COMMANDS);
+    memcpy(rdp_commands[num_rdp_commands], buffer, command_length * sizeof(u32));
+    rdp_command_lengths[num_rdp_commands] = command_length;
+    num_rdp_commands++;
+}
+
+int count_triangles() {
+    int triangles = 0;
+    for (int i = 0; i < num_rdp_commands; i++) {
+        u8 command = (rdp_commands[i][0] >> 24) & 0x3F;
+        triangles += command >= 0x08 && command <= 0x0F;
+    }
+    return triangles;
+}
+
+static u32 dl_address;
+
+void start_display_list(u32 address) {
+    dl_address = address;
+}
+
+void command(u32 w0, u32 w1) {
+    hle_rdram_write_u32(dl_address, w0);
+    hle_rdram_write_u32(dl_address + 4, w1);
+    dl_address += 8;
+}
+
+void run(rsp_hle_gfx_ucode_t ucode, u32 address) {
+    num_rdp_commands = 0;
+    rsp_hle_gfx_run(ucode, address);
+}
+
+void write_vertex(u32 address, int index, s16 x, s16 y, s16 z) {
+    address += index * 16;
+    hle_rdram_write_s16(address + 0, x);
+    hle_rdram_write_s16(address + 2, y);
+    hle_rdram_write_s16(address + 4, z);
+    hle_rdram_write_s16(address + 6, 0);
+    hle_rdram_write_u32(address + 8, 0);
+    hle_rdram_write_u32(address + 12, 0xFFFFFFFF);
+}
+
+// Scales x, y and z down by 64, so vertices 64 units out land on the edge of the default 320x240 viewport.
+// s15.16, all the integer halves and then all the fractions.
+void write_projection() {
+    for (int i = 0; i < 32; i++) {
+        hle_rdram_write_s16(PROJECTION + i * 2, 0);
+    }
+    hle_rdram_write_s16(PROJECTION + 15 * 2, 1); // [3][3] = 1.0
+    hle_rdram_write_s16(PROJECTION + 32 + 0 * 2, 0x0400); // [0][0] = 1/64
+    hle_rdram_write_s16(PROJECTION + 32 + 5 * 2, 0x0400); // [1][1] = 1/64
+    hle_rdram_write_s16(PROJECTION + 32 + 10 * 2, 0x0400); // [2][2] = 1/64
+}
+
+void assert_vertex(const char* name, int index, float x, float y, float z) {
+    float screen[3];
+    rsp_hle_gfx_vertex_screen(index, screen);
+    ASSERT_INT_EQUALS(name, (long)x, (long)screen[0]);
+    ASSERT_INT_EQUALS(name, (long)y, (long)screen[1]);
+    ASSERT_INT_EQUALS(name, (long)z, (long)screen[2]);
+}
+
+void test_f3d_triangle() {
+    write_projection();
+    write_vertex(VERTICES, 0, -32,  32, 0);
+    write_vertex(VERTICES, 1, -32, -32, 0);
+    write_vertex(VERTICES, 2,  32, -32, 0);
+
+    start_display_list(DISPLAY_LIST);
+    command(G_MTX << 24 | (G_MTX_PROJECTION | G_MTX_LOAD) << 16 | 0x40, PROJECTION);
+    command(G_VTX << 24 | (3 - 1) << 20 | 0 << 16 | 3 * 16, VERTICES);
+    command(G_TRI1 << 24, 0 << 24 | 0 * 10 << 16 | 1 * 10 << 8 | 2 * 10);
+    command(G_SETPRIMCOLOR << 24, 0x11223344);
+    command(G_MOVEWORD << 24 | (1 * 4) << 8 | G_MW_SEGMENT, 0x200000);
+    command(G_SETCIMG << 24, 0x01000100);
+    command(G_ENDDL << 24, 0);
+    run(GFX_UCODE_F3D, DISPLAY_LIST);
+
+    // x and y through the projection and the viewport, z in 15 bits from the middle of the viewport's depth range
+    assert_vertex("top left vertex", 0, 80, 60, 511 * 32);
+    assert_vertex("bottom left vertex", 1, 80, 180, 511 * 32);
+    assert_vertex("bottom right vertex", 2, 240, 180, 511 * 32);
+
+    ASSERT_INT_EQUALS("RDP commands", 3, num_rdp_commands);
+
+    // A flat fill triangle, with its edges from the top vertex
+    const u32* triangle = rdp_commands[0];
+    ASSERT_INT_EQUALS("triangle length", 8, rdp_command_lengths[0]);
+    ASSERT_INT_EQUALS("triangle command and y low", 0x08 << 24 | 180 * 4, triangle[0]);
+    ASSERT_INT_EQUALS("triangle y mid and high", (180 * 4) << 16 | 60 * 4, triangle[1]);
+    ASSERT_INT_EQUALS("triangle x low", 80 << 16, triangle[2]);
+    ASSERT_INT_EQUALS("triangle x low slope", 0, triangle[3]);
+    ASSERT_INT_EQUALS("triangle x high", 80 << 16, triangle[4]);
+    ASSERT_INT_EQUALS("triangle x high slope", (u32)(160.0 / 120.0 * 65536), triangle[5]);
+    ASSERT_INT_EQUALS("triangle x mid", 80 << 16, triangle[6]);
+    ASSERT_INT_EQUALS("triangle x mid slope", 0, triangle[7]);
+
+    // RDP commands go through as they are, apart from addresses, which are segmented
+    ASSERT_INT_EQUALS("prim colour length", 2, rdp_command_lengths[1]);
+    ASSERT_INT_EQUALS("prim colour", (u32)G_SETPRIMCOLOR << 24, rdp_commands[1][0]);
+    ASSERT_INT_EQUALS("prim colour", 0x11223344, rdp_commands[1][1]);
+    ASSERT_INT_EQUALS("colour image", (u32)G_SETCIMG << 24, rdp_commands[2][0]);
+    ASSERT_INT_EQUALS("colour image address", 0x200100, rdp_commands[2][1]);
+}
+
+void test_dl_stack_overflow() {
+    // Each list marks how deep it is and calls the next one down
+    for (int level = 0; level <= DL_STACK_SIZE + 1; level++) {
+        start_display_list(NESTED_LISTS + level * 0x100);
+        command(G_SETPRIMCOLOR << 24, level);
+        command(G_DL << 24, NESTED_LISTS + (level + 1) * 0x100);
+        command(G_ENDDL << 24, 0);
+    }
+    run(GFX_UCODE_F3D, NESTED_LISTS);
+
+    // The call that would overflow the stack is skipped, and every list returns to the one that called it
+    ASSERT_INT_EQUALS("lists run before the stack is full", DL_STACK_SIZE + 1, num_rdp_commands);
+    for (int level = 0; level <= DL_STACK_SIZE; level++) {
+        ASSERT_INT_EQUALS("list depth", level, rdp_commands[level][1]);
+    }
+}
+
+void test_vertex_overflow() {
+    write_projection();
+    write_vertex(VERTICES, 0, -32,  32, 0);
+    write_vertex(VERTICES, 1, -32, -32, 0);
+    write_vertex(VERTICES, 2,  32, -32, 0);
+    for (int i = 0; i < 3; i++) {
+        write_vertex(VERTICES + 0x100, i, 32, 32, 0);
+    }
+
+    // F3DEX takes vertex indices doubled, and can ask for more vertices than there's room for
+    const int last = MAX_VERTICES - 3;
+    start_display_list(DISPLAY_LIST);
+    command(G_MTX << 24 | (G_MTX_PROJECTION | G_MTX_LOAD) << 16 | 0x40, PROJECTION);
+    command(G_VTX << 24 | (last * 2) << 16 | 3 << 10 | (3 * 16 - 1), VERTICES);
+    command(G_VTX << 24 | ((last + 1) * 2) << 16 | 3 << 10 | (3 * 16 - 1), VERTICES + 0x100);
+    command(G_TRI1 << 24, last * 2 << 16 | (last + 1) * 2 << 8 | (last + 2) * 2);
+    command(G_TRI1 << 24, last * 2 << 16 | (last + 1) * 2 << 8 | MAX_VERTICES * 2);
+    command(G_ENDDL << 24, 0);
+    run(GFX_UCODE_F3DEX, DISPLAY_LIST);
+
+    // The load that runs off the end of the buffer is dropped, leaving the vertices that were there
+    assert_vertex("vertex before the overflowing load", last + 1, 80, 180, 511 * 32);
+    assert_vertex("vertex before the overflowing load", last + 2, 240, 180, 511 * 32);
+    ASSERT_INT_EQUALS("only the triangle with all its vertices in the buffer is drawn", 1, count_triangles());
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    rsp_hle_gfx_rdp_command = record_rdp_command;
+
+    test_f3d_triangle();
+    test_dl_stack_overflow();
+    test_vertex_overflow();
+    printf("Passed!\n");
+}
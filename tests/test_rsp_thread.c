@@ -0,0 +1,72 @@
+#include <system/n64system.h>
+#include <system/rsp_thread.h>
+#include <cpu/rsp.h>
+#include <mem/mem_util.h>
+
+#include "unit.h"
+
+// Instructions in a task, counting the break
+#define TASK_LENGTH 20
+
+#define SP_STATUS_CLEAR_INTR 0x08
+#define SP_STATUS_SET_INTR   0x10
+
+// Writes first and then second to the SP status from the RSP, then runs out its length in nops and breaks
+void upload_task(u16 first, u16 second) {
+    word_to_byte_array(N64RSP.sp_imem, 0, OPC_ADDIU << 26 | 1 << 16 | first); // addiu $1, $0, first
+    word_to_byte_array(N64RSP.sp_imem, 4, OPC_CP0 << 26 | COP_MT << 21 | 1 << 16 | RSP_CP0_SP_STATUS << 11); // mtc0 $1, SP_STATUS
+    word_to_byte_array(N64RSP.sp_imem, 8, OPC_ADDIU << 26 | 1 << 16 | second); // addiu $1, $0, second
+    word_to_byte_array(N64RSP.sp_imem, 12, OPC_CP0 << 26 | COP_MT << 21 | 1 << 16 | RSP_CP0_SP_STATUS << 11); // mtc0 $1, SP_STATUS
+    for (int i = 4; i < TASK_LENGTH - 1; i++) {
+        word_to_byte_array(N64RSP.sp_imem, i * 4, 0); // nop
+    }
+    word_to_byte_array(N64RSP.sp_imem, (TASK_LENGTH - 1) * 4, FUNCT_BREAK);
+    invalidate_rsp_icache_range(0, TASK_LENGTH * 4);
+
+    N64RSP.pc = 0;
+    N64RSP.next_pc = 1;
+    N64RSP.status.intr_on_break = false;
+    N64RSP.status.halt = false;
+    n64sys.mi.intr.sp = false;
+    set_metric(METRIC_SP_INTERRUPT, 0);
+}
+
+// Hands the RSP a batch and waits for it to finish
+void run_task() {
+    rsp_thread_step(1);
+    ASSERT_INT_EQUALS("no batch before the CPU owes a quantum", false, rsp_thread_busy);
+
+    rsp_thread_step(RSP_THREAD_QUANTUM / 2 * 3);
+    ASSERT_INT_EQUALS("batch handed to the RSP thread", true, rsp_thread_busy);
+    // Until the CPU syncs, nothing the RSP did to the interrupts can show
+    ASSERT_INT_EQUALS("no interrupt raised before the sync", 0, get_metric(METRIC_SP_INTERRUPT));
+    ASSERT_INT_EQUALS("no interrupt pending before the sync", false, n64sys.mi.intr.sp);
+
+    rsp_thread_sync();
+    ASSERT_INT_EQUALS("batch done after the sync", false, rsp_thread_busy);
+    ASSERT_INT_EQUALS("ran to the break", true, N64RSP.status.halt);
+}
+
+int main(int argc, char** argv) {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+    rsp_thread_start();
+
+    // Raised and lowered again within the batch: the interrupt still gets raised, and ends up lowered
+    upload_task(SP_STATUS_SET_INTR, SP_STATUS_CLEAR_INTR);
+    run_task();
+    ASSERT_INT_EQUALS("raise then lower raises", 1, get_metric(METRIC_SP_INTERRUPT));
+    ASSERT_INT_EQUALS("raise then lower ends lowered", false, n64sys.mi.intr.sp);
+
+    // The other way round ends up raised
+    upload_task(SP_STATUS_CLEAR_INTR, SP_STATUS_SET_INTR);
+    run_task();
+    ASSERT_INT_EQUALS("lower then raise raises", 1, get_metric(METRIC_SP_INTERRUPT));
+    ASSERT_INT_EQUALS("lower then raise ends raised", true, n64sys.mi.intr.sp);
+
+    // A halted RSP isn't handed anything
+    rsp_thread_step(RSP_THREAD_QUANTUM / 2 * 3);
+    ASSERT_INT_EQUALS("no batch for a halted RSP", false, rsp_thread_busy);
+
+    rsp_thread_stop();
+    printf("Passed!\n");
+}
@@ -0,0 +1,92 @@
+#include <system/n64system.h>
+#include <system/scheduler.h>
+#include <cpu/r4300i_register_access.h>
+
+#include "unit.h"
+
+// Ticks one cycle at a time until an event comes out, up to max_cycles
+bool tick_until_event(u64 max_cycles, scheduler_event_t* event) {
+    for (u64 i = 0; i < max_cycles; i++) {
+        if (scheduler_tick(1, event)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void test_event_order() {
+    scheduler_reset();
+    scheduler_event_t event;
+
+    // Something due soon, queued behind something due much later
+    scheduler_enqueue_absolute(1000000, SCHEDULER_COMPARE_INTERRUPT);
+    scheduler_enqueue_relative(1000, SCHEDULER_PI_DMA_COMPLETE);
+    scheduler_enqueue_relative(500, SCHEDULER_SI_DMA_COMPLETE);
+
+    ASSERT_INT_EQUALS("first event fired", true, tick_until_event(2000000, &event));
+    ASSERT_INT_EQUALS("first event type", SCHEDULER_SI_DMA_COMPLETE, event.type);
+    ASSERT_INT_EQUALS("first event time", 501, scheduler_ticks);
+
+    ASSERT_INT_EQUALS("second event fired", true, tick_until_event(2000000, &event));
+    ASSERT_INT_EQUALS("second event type", SCHEDULER_PI_DMA_COMPLETE, event.type);
+    ASSERT_INT_EQUALS("second event time", 1001, scheduler_ticks);
+
+    ASSERT_INT_EQUALS("third event fired", true, tick_until_event(2000000, &event));
+    ASSERT_INT_EQUALS("third event type", SCHEDULER_COMPARE_INTERRUPT, event.type);
+    ASSERT_INT_EQUALS("third event time", 1000001, scheduler_ticks);
+
+    ASSERT_INT_EQUALS("nothing left", false, tick_until_event(2000000, &event));
+}
+
+// Runs the system's scheduler for this many cycles, without the CPU
+void run_cycles(u64 cycles) {
+    scheduler_event_t event;
+    for (u64 i = 0; i < cycles; i++) {
+        if (scheduler_tick(1, &event)) {
+            handle_scheduler_event(&event);
+        }
+    }
+}
+
+void test_count_compare() {
+    init_n64system(NULL, false, false, UNKNOWN_VIDEO_TYPE, false);
+
+    set_cp0_register_word(R4300I_CP0_REG_COUNT, 0);
+    set_cp0_register_word(R4300I_CP0_REG_COMPARE, 100);
+
+    // Count goes up once every 2 cycles
+    run_cycles(51);
+    ASSERT_INT_EQUALS("count after 51 cycles", 25, get_cp0_count());
+    ASSERT_INT_EQUALS("no interrupt before count reaches compare", false, N64CP0.cause.ip7);
+
+    run_cycles(149);
+    ASSERT_INT_EQUALS("count after 200 cycles", 100, get_cp0_count());
+    ASSERT_INT_EQUALS("no interrupt until the cycle after count reaches compare", false, N64CP0.cause.ip7);
+    run_cycles(1);
+    ASSERT_INT_EQUALS("interrupt once count reaches compare", true, N64CP0.cause.ip7);
+
+    // Writing compare acknowledges it, and moving count back re-arms it
+    set_cp0_register_word(R4300I_CP0_REG_COMPARE, 100);
+    ASSERT_INT_EQUALS("compare write clears the interrupt", false, N64CP0.cause.ip7);
+    set_cp0_register_word(R4300I_CP0_REG_COUNT, 90);
+    ASSERT_INT_EQUALS("count reads back as written", 90, get_cp0_count());
+    run_cycles(20);
+    ASSERT_INT_EQUALS("no interrupt before the rewritten count reaches compare", false, N64CP0.cause.ip7);
+    run_cycles(1);
+    ASSERT_INT_EQUALS("interrupt once the rewritten count reaches compare", true, N64CP0.cause.ip7);
+
+    // Other events queued after the compare event still go off on time
+    set_cp0_register_word(R4300I_CP0_REG_COMPARE, 0x80000000);
+    u64 start = scheduler_ticks;
+    scheduler_enqueue_relative(1000, SCHEDULER_PI_BUS_WRITE_COMPLETE);
+    scheduler_event_t event;
+    ASSERT_INT_EQUALS("event behind compare fired", true, tick_until_event(2000, &event));
+    ASSERT_INT_EQUALS("event behind compare type", SCHEDULER_PI_BUS_WRITE_COMPLETE, event.type);
+    ASSERT_INT_EQUALS("event behind compare time", 1001, scheduler_ticks - start);
+}
+
+int main(int argc, char** argv) {
+    test_event_order();
+    test_count_compare();
+    printf("Passed!\n");
+}
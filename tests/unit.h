@@ -1,7 +1,15 @@
 #ifndef N64_UNIT_H
 #define N64_UNIT_H
+#include <string.h>
 #include <cpu/r4300i_register_access.h>
 
+#ifndef SHOULD_LOG_PASSED_TESTS
+#define SHOULD_LOG_PASSED_TESTS false
+#endif
+
+#define ASSERT_INT_EQUALS(message, expected, actual) do { long _expected = (expected); long _actual = (actual); if (_expected != _actual) { logfatal("assert failed! [%s] expected %ld != actual %ld", message, _expected, _actual); } } while(0)
+#define ASSERT_TRUE(message, value) do { if (!(value)) { logfatal("assert failed! [%s]", message); } } while(0)
+
 static int tests_failed = 0;
 
 #define failed(message,...) if (1) { \